@@ -0,0 +1,439 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+/*
+ * Headless benchmark of the detection filters.
+ * The whole chain of filters created through do_create_filter is fed directly from
+ * the workload generator (or a recorded stream). With --per-stage, each filter is also
+ * measured alone, fed with the captured output of the previous stage. With --async, the stages
+ * of the chain are decoupled by asynchronous queues and run on separate threads. With --fused,
+ * the smoothing runs inside the CHO detection filter instead of the Savitzky-Golay filter.
+ * With --savgol-slope, CHO detection uses the Savitzky-Golay derivative as the slope.
+ */
+
+#include <rtl/FilterLib.h>
+
+#include "../src/descriptor.h"
+#include "../src/metrics.h"
+#include "../src/trace.h"
+#include "host/sink_filter.h"
+#include "event_stream.h"
+#include "workload_generator.h"
+#include "golden.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+	//period of the metrics Information events in minutes
+	int64_t metrics_period = 0;
+	//eviction of the segment state
+	int64_t segment_ttl = 0;
+	int64_t max_segments = 0;
+
+	//golden output of the chain
+	std::string golden_path;
+	CGolden_Filter::NMode golden_mode = CGolden_Filter::NMode::Record;
+	TGolden_Tolerance golden_tolerance;
+
+	//snapshots of the filter state and simulated restart of the chain
+	std::string snapshot_dir;
+	double restart_days = 0;
+
+	//asynchronous queues between the stages of the chain
+	bool async = false;
+	int64_t queue_size = 4096;
+	int64_t batch_size = 64;
+
+	struct TStage {
+		const char* name;
+		const char* key;
+		GUID id;
+		std::function<void(scgms::SFilter_Configuration&)> configure;
+	};
+
+	scgms::IFilter* create_filter(const TStage& stage, scgms::IFilter* output) {
+		scgms::IFilter* filter = nullptr;
+		if (!Succeeded(do_create_filter(&stage.id, output, &filter))) {
+			std::cerr << "cannot create filter " << stage.name << std::endl;
+			std::exit(1);
+		}
+
+		scgms::SFilter_Configuration configuration;
+		stage.configure(configuration);
+		configuration.Set(detection::rsMetricsPeriod, metrics_period);
+		configuration.Set(detection::rsSegmentTTL, segment_ttl);
+		configuration.Set(detection::rsMaxSegments, max_segments);
+		if (!snapshot_dir.empty()) {
+			configuration.Set(detection::rsSnapshotPath, (filesystem::path(snapshot_dir) / (std::string(stage.key) + ".state")).wstring());
+		}
+		refcnt::Swstr_list errors;
+		if (!Succeeded(filter->Configure(configuration, errors))) {
+			std::cerr << "cannot configure filter " << stage.name << std::endl;
+			for (const auto& e : errors.items()) std::wcerr << L"  " << e << std::endl;
+			std::exit(1);
+		}
+
+		return filter;
+	}
+
+	/*Source of the input events, returns false at the end of the stream*/
+	using TEvent_Source = std::function<bool(scgms::UDevice_Event&)>;
+
+	TEvent_Source vector_source(std::vector<scgms::UDevice_Event>& events) {
+		return [&events, it = events.begin()](scgms::UDevice_Event& event) mutable {
+			if (it == events.end()) return false;
+			event = std::move(*it++);
+			return true;
+		};
+	}
+
+	/*Sends all events to the filter and returns elapsed seconds*/
+	double execute(scgms::IFilter* const& filter, const TEvent_Source& source, size_t& count) {
+		count = 0;
+		scgms::UDevice_Event event;
+		const auto start = std::chrono::steady_clock::now();
+		while (source(event)) {
+			count++;
+			if (!Succeeded(filter->Execute(std::move(event)))) {
+				std::cerr << "filter execution failed" << std::endl;
+				std::exit(1);
+			}
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/*Peak resident set size in MB*/
+	double peak_memory() {
+#ifndef _WIN32
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / 1024.0;
+#else
+		return 0.0;
+#endif
+	}
+
+	void report(const char* name, size_t events, double seconds, const scgms::TEvent_Factory_Stats& stats) {
+		std::printf("%-24s %12zu %14.0f %12.1f %12llu %12llu\n", name, events, events / seconds, seconds * 1e9 / events,
+			static_cast<unsigned long long>(stats.created), static_cast<unsigned long long>(stats.allocated));
+	}
+
+	/*Runs the stage alone, output of the stage replaces the input*/
+	void run_stage(const TStage& stage, std::vector<scgms::UDevice_Event>& events) {
+		auto sink = new CSink_Filter(true);
+		sink->AddRef();
+		scgms::IFilter* filter = create_filter(stage, sink);
+
+		size_t count;
+		scgms::reset_event_factory_stats();
+		const double seconds = execute(filter, vector_source(events), count);
+		report(stage.name, count, seconds, scgms::event_factory_stats());
+
+		events = sink->take_events();
+		filter->Release();
+		sink->Release();
+	}
+
+	/*Runs all stages connected to one chain, the input is streamed from the source
+	 * Returns false when the output differs from the golden output.
+	 */
+	bool run_chain(const std::vector<TStage>& stages, const TEvent_Source& source) {
+		auto sink = new CSink_Filter();
+		sink->AddRef();
+
+		CGolden_Filter* golden = nullptr;
+		if (!golden_path.empty()) {
+			golden = new CGolden_Filter(sink, golden_mode, golden_path, golden_tolerance);
+			golden->AddRef();
+		}
+
+		std::vector<scgms::IFilter*> filters;
+		scgms::IFilter* const last = golden ? static_cast<scgms::IFilter*>(golden) : sink;
+		auto create_chain = [&]() {
+			scgms::IFilter* output = last;
+			for (auto it = stages.rbegin(); it != stages.rend(); ++it) {
+				output = create_filter(*it, output);
+				filters.push_back(output);
+			}
+			return output;
+		};
+		scgms::IFilter* input = create_chain();
+
+		//restart shuts the chain down (filters write snapshots) and creates it again (filters restore snapshots)
+		double first_time = -1;
+		bool restarted = false;
+		auto chain_source = [&](scgms::UDevice_Event& event) {
+			if (!source(event)) return false;
+			if (restart_days <= 0 || restarted || !event.is_level_event()) return true;
+
+			if (first_time < 0) first_time = event.device_time();
+			if (event.device_time() - first_time >= restart_days) {
+				restarted = true;
+				scgms::UDevice_Event shut_down(scgms::NDevice_Event_Code::Shut_Down);
+				shut_down.device_time() = event.device_time();
+				input->Execute(std::move(shut_down));
+
+				for (auto filter : filters) filter->Release();
+				filters.clear();
+				input = create_chain();
+			}
+			return true;
+		};
+
+		size_t count;
+		scgms::reset_event_factory_stats();
+		const double seconds = execute(input, chain_source, count);
+		report("chain", count, seconds, scgms::event_factory_stats());
+
+		//the last info of each filter holds its totals
+		std::map<std::wstring, std::wstring> last_infos;
+		for (const auto& info : sink->infos()) last_infos[info.substr(0, info.find(L':'))] = info;
+		for (const auto& info : last_infos) std::wcout << L"  " << info.second << std::endl;
+		std::printf("  peak memory: %.1f MB\n", peak_memory());
+
+		//self time of the filters in the chain, downstream filters excluded
+		if (detection::CFilter_Metrics::enabled) {
+			std::printf("%-24s %12s %10s %10s %10s %10s %12s %10s %12s %10s %12s\n", "filter", "events", "mean ns", "p50 ns", "p99 ns", "max ns", "emitted", "segments", "state kB", "evicted", "allocations");
+			for (const auto& m : detection::metrics_snapshot()) {
+				std::printf("%-24ls %12llu %10.0f %10llu %10llu %10llu %12llu %10llu %12llu %10llu %12llu\n", m.filter.c_str(), static_cast<unsigned long long>(m.events), m.mean,
+					static_cast<unsigned long long>(m.p50), static_cast<unsigned long long>(m.p99), static_cast<unsigned long long>(m.max),
+					static_cast<unsigned long long>(m.emitted), static_cast<unsigned long long>(m.segments), static_cast<unsigned long long>(m.state_bytes / 1024), static_cast<unsigned long long>(m.evicted),
+					static_cast<unsigned long long>(m.allocations));
+
+				//stages of the filter, wall time without the sent events
+				for (size_t i = 0; i < detection::stage_count; ++i) {
+					const auto& s = m.stages[i];
+					if (s.count == 0) continue;
+					std::printf("  %-22ls %12llu %10.0f %10llu %10llu %10llu %60llu\n", detection::stage_name(static_cast<detection::NStage>(i)), static_cast<unsigned long long>(s.count), s.mean,
+						static_cast<unsigned long long>(s.p50), static_cast<unsigned long long>(s.p99), static_cast<unsigned long long>(s.max), static_cast<unsigned long long>(s.allocations));
+				}
+			}
+		}
+
+		bool result = true;
+		if (golden) {
+			result = golden->finish();
+			std::printf("golden: %zu events %s, %zu divergent\n", golden->events(), golden_mode == CGolden_Filter::NMode::Record ? "recorded" : "compared", golden->divergences());
+			golden->Release();
+		}
+
+		for (auto filter : filters) filter->Release();
+		sink->Release();
+
+		return result;
+	}
+
+	void usage() {
+		std::cout << "detection_bench [--segments N] [--days D] [--seed S] [--noise SD] [--gaps P] [--per-stage] [--fused] [--savgol-slope] [--cho-window N] [--pa-window MIN] [--pa-bin S [--pa-bin-mean]] [--acc-rate N] [--acc-bin S [--acc-resolutions \"MIN;...\"]] [--ensemble \"TL,WL,TH,WH,ACT,DESC;...\"] [--output all|change|nonzero [--output-heartbeat MIN]] [--sweep \"D,C;...\"] [--statistics file.csv|file.bin] [--offline-eval] [--no-metrics] [--metrics-sample N] [--metrics-period MIN] [--segment-ttl MIN] [--max-segments N] [--trace trace.json] [--snapshot-dir DIR [--restart-at DAYS]] [--async [--queue-size N] [--batch-size N]] [--record golden.bin | --compare golden.bin [--tolerance ABS] [--rel-tolerance REL]] [--input recorded.csv]" << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	TWorkload_Params params;
+	std::string input;
+	bool per_stage = false;
+	bool fused = false;
+	bool savgol_slope = false;
+	int64_t cho_window = 12;
+	int64_t pa_window = 0;
+	int64_t pa_bin = 0;
+	bool pa_bin_mean = false;
+	int64_t acc_bin = 0;
+	std::wstring acc_resolutions;
+	std::wstring ensemble;
+	std::wstring output;
+	std::wstring sweep;
+	std::wstring statistics_path;
+	bool offline_eval = false;
+	int64_t output_heartbeat = 0;
+	std::string trace_path;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool has_value = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--segments") && has_value) params.segments = std::stoul(argv[++i]);
+		else if (!std::strcmp(argv[i], "--days") && has_value) params.days = std::stod(argv[++i]);
+		else if (!std::strcmp(argv[i], "--seed") && has_value) params.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (!std::strcmp(argv[i], "--noise") && has_value) params.noise = std::stod(argv[++i]);
+		else if (!std::strcmp(argv[i], "--gaps") && has_value) params.gap_probability = std::stod(argv[++i]);
+		else if (!std::strcmp(argv[i], "--per-stage")) per_stage = true;
+		else if (!std::strcmp(argv[i], "--fused")) fused = true;
+		else if (!std::strcmp(argv[i], "--savgol-slope")) savgol_slope = true;
+		else if (!std::strcmp(argv[i], "--cho-window") && has_value) cho_window = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--pa-window") && has_value) pa_window = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--pa-bin") && has_value) pa_bin = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--pa-bin-mean")) pa_bin_mean = true;
+		else if (!std::strcmp(argv[i], "--acc-rate") && has_value) params.acceleration_rate = std::stoul(argv[++i]);
+		else if (!std::strcmp(argv[i], "--acc-bin") && has_value) acc_bin = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--acc-resolutions") && has_value) acc_resolutions = filesystem::path(argv[++i]).wstring();
+		else if (!std::strcmp(argv[i], "--ensemble") && has_value) ensemble = filesystem::path(argv[++i]).wstring();
+		else if (!std::strcmp(argv[i], "--output") && has_value) output = filesystem::path(argv[++i]).wstring();
+		else if (!std::strcmp(argv[i], "--output-heartbeat") && has_value) output_heartbeat = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--sweep") && has_value) sweep = filesystem::path(argv[++i]).wstring();
+		else if (!std::strcmp(argv[i], "--statistics") && has_value) statistics_path = filesystem::path(argv[++i]).wstring();
+		else if (!std::strcmp(argv[i], "--offline-eval")) offline_eval = true;
+		else if (!std::strcmp(argv[i], "--no-metrics")) detection::CFilter_Metrics::enabled = false;
+		else if (!std::strcmp(argv[i], "--metrics-sample") && has_value) detection::CFilter_Metrics::sample_period = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+		else if (!std::strcmp(argv[i], "--metrics-period") && has_value) metrics_period = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--segment-ttl") && has_value) segment_ttl = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--max-segments") && has_value) max_segments = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--trace") && has_value) trace_path = argv[++i];
+		else if (!std::strcmp(argv[i], "--snapshot-dir") && has_value) snapshot_dir = argv[++i];
+		else if (!std::strcmp(argv[i], "--restart-at") && has_value) restart_days = std::stod(argv[++i]);
+		else if (!std::strcmp(argv[i], "--async")) async = true;
+		else if (!std::strcmp(argv[i], "--queue-size") && has_value) queue_size = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--batch-size") && has_value) batch_size = std::stoll(argv[++i]);
+		else if (!std::strcmp(argv[i], "--record") && has_value) {
+			golden_path = argv[++i];
+			golden_mode = CGolden_Filter::NMode::Record;
+		}
+		else if (!std::strcmp(argv[i], "--compare") && has_value) {
+			golden_path = argv[++i];
+			golden_mode = CGolden_Filter::NMode::Compare;
+		}
+		else if (!std::strcmp(argv[i], "--tolerance") && has_value) golden_tolerance.absolute = std::stod(argv[++i]);
+		else if (!std::strcmp(argv[i], "--rel-tolerance") && has_value) golden_tolerance.relative = std::stod(argv[++i]);
+		else if (!std::strcmp(argv[i], "--input") && has_value) input = argv[++i];
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	//timings in the metrics information events are not reproducible
+	if (!golden_path.empty() && metrics_period > 0) {
+		std::cerr << "golden output cannot be used with --metrics-period" << std::endl;
+		return 1;
+	}
+
+	std::vector<TStage> stages = {
+		{ "Savitzky-Golay filter", "savgol", detection::id_savgol, [](scgms::SFilter_Configuration& c) {
+			c.Set(detection::rsSignal, scgms::signal_IG);
+			c.Set(detection::rsSavgolWindow, int64_t(21));
+			c.Set(detection::rsSavgolDeg, int64_t(3));
+		} },
+		{ "CHO detection", "cho", detection::id_cho, [cho_window, ensemble, output, output_heartbeat](scgms::SFilter_Configuration& c) {
+			c.Set(detection::rsSignal, detection::signal_savgol);
+			c.Set(detection::rsWindowSize, cho_window);
+			c.Set(detection::rsEnsemble, ensemble);
+			c.Set(detection::rsThresholds, std::vector<double>{ 0.0125, 2.25, 0.018, 3.0 });
+			c.Set(detection::rsEdges, true);
+			c.Set(detection::rsDesc, true);
+			c.Set(detection::rsThAct, 2.0);
+			c.Set(detection::rsActivationOutput, output);
+			c.Set(detection::rsDetectionOutput, output);
+			c.Set(detection::rsOutputHeartbeat, output_heartbeat);
+		} },
+		{ "PA detection", "pa", detection::id_pa, [pa_window, pa_bin, pa_bin_mean, acc_bin, acc_resolutions, acc = params.acceleration_rate > 1 || acc_bin > 0, output, output_heartbeat](scgms::SFilter_Configuration& c) {
+			c.Set(detection::rsSHeartbeat, true);
+			c.Set(detection::rsSSteps, true);
+			c.Set(detection::rsSAcc, acc);
+			c.Set(detection::rsMean, true);
+			c.Set(detection::rsMeanSize, int64_t(6));
+			c.Set(detection::rsMeanDuration, pa_window);
+			c.Set(detection::rsAlignBin, pa_bin);
+			c.Set(detection::rsAlignMean, pa_bin_mean);
+			c.Set(detection::rsAccBin, acc_bin);
+			c.Set(detection::rsAccResolutions, acc_resolutions);
+			c.Set(detection::rsActivationOutput, output);
+			c.Set(detection::rsDetectionOutput, output);
+			c.Set(detection::rsOutputHeartbeat, output_heartbeat);
+			c.Set(detection::rsThresholds, std::vector<double>{ 80.0, 20.0, 1.1, 10.0, -0.0125, -2.25, -0.018, -3.0 });
+		} },
+		{ "Evaluation", "eval", detection::id_eval, [sweep, statistics_path, offline_eval](scgms::SFilter_Configuration& c) {
+			c.Set(detection::rsSignalRef, scgms::signal_Carb_Intake);
+			c.Set(detection::rsSignalDet, detection::signal_cho);
+			c.Set(detection::rsMaxDelay, int64_t(180));
+			c.Set(detection::rsFPDelay, int64_t(120));
+			c.Set(detection::rsLateDelay, int64_t(10));
+			c.Set(detection::rsThresholdSweep, sweep);
+			c.Set(detection::rsStatisticsPath, statistics_path);
+			c.Set(detection::rsOfflineMatching, offline_eval);
+		} }
+	};
+
+	//derivative of the Savitzky-Golay fit instead of the difference of two smoothed samples
+	if (savgol_slope) {
+		for (auto& stage : { &stages[0], &stages[1] }) {
+			auto configure = stage->configure;
+			stage->configure = [configure](scgms::SFilter_Configuration& c) {
+				configure(c);
+				c.Set(detection::rsSavgolDerivative, true);
+				c.Set(detection::rsSlopeSignal, detection::signal_savgol_derivative);
+			};
+		}
+	}
+
+	//CHO detection smooths IG itself and sends the smoothed signal for comparison with the separate filters
+	if (fused) {
+		auto configure = stages[1].configure;
+		stages[1].configure = [configure](scgms::SFilter_Configuration& c) {
+			configure(c);
+			c.Set(detection::rsSignal, scgms::signal_IG);
+			c.Set(detection::rsSmooth, true);
+			c.Set(detection::rsSavgolWindow, int64_t(21));
+			c.Set(detection::rsSavgolDeg, int64_t(3));
+			c.Set(detection::rsSmoothOutput, true);
+		};
+		stages.erase(stages.begin());
+	}
+
+	std::printf("%-24s %12s %14s %12s %12s %12s\n", "filter", "events", "events/s", "ns/event", "created", "allocated");
+
+	//isolated stages need the output of the previous stage, so their input is materialized
+	if (per_stage) {
+		std::vector<scgms::UDevice_Event> events;
+		if (input.empty()) {
+			CWorkload_Generator generator(params);
+			scgms::UDevice_Event event;
+			while (generator.next(event)) events.push_back(std::move(event));
+		}
+		else {
+			events = recorded_stream(input);
+		}
+
+		for (const auto& stage : stages) {
+			run_stage(stage, events);
+		}
+	}
+
+	if (async) {
+		const TStage queue = { "Asynchronous queue", "async", detection::id_async, [](scgms::SFilter_Configuration& c) {
+			c.Set(detection::rsQueueSize, queue_size);
+			c.Set(detection::rsBatchSize, batch_size);
+		} };
+		for (size_t i = stages.size() - 1; i > 0; i--) {
+			stages.insert(stages.begin() + i, queue);
+		}
+	}
+
+	//only the chain is traced
+	if (!trace_path.empty()) detection::trace::start(trace_path);
+
+	bool matches;
+	if (input.empty()) {
+		CWorkload_Generator generator(params);
+		matches = run_chain(stages, [&generator](scgms::UDevice_Event& event) { return generator.next(event); });
+	}
+	else {
+		auto events = recorded_stream(input);
+		matches = run_chain(stages, vector_source(events));
+	}
+
+	if (!trace_path.empty() && !detection::trace::stop()) {
+		std::cerr << "cannot write trace " << trace_path << std::endl;
+		return 1;
+	}
+
+	return matches ? 0 : 2;
+}
@@ -0,0 +1,82 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "event_stream.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+	scgms::UDevice_Event make_event(scgms::NDevice_Event_Code code, uint64_t segment, double time) {
+		scgms::UDevice_Event event(code);
+		event.segment_id() = segment;
+		event.device_time() = time;
+		return event;
+	}
+
+	scgms::UDevice_Event make_level(uint64_t segment, double time, const GUID& signal, double level) {
+		scgms::UDevice_Event event = make_event(scgms::NDevice_Event_Code::Level, segment, time);
+		event.signal_id() = signal;
+		event.level() = level;
+		return event;
+	}
+}
+
+bool signal_by_name(const std::string& name, GUID& signal) {
+	static const std::map<std::string, GUID> signals = {
+		{ "ig", scgms::signal_IG },
+		{ "bg", scgms::signal_BG },
+		{ "carbs", scgms::signal_Carb_Intake },
+		{ "pa", scgms::signal_Physical_Activity },
+		{ "heartbeat", scgms::signal_Heartbeat },
+		{ "steps", scgms::signal_Steps },
+		{ "acceleration", scgms::signal_Acceleration },
+		{ "eda", scgms::signal_Electrodermal_Activity }
+	};
+
+	auto it = signals.find(name);
+	if (it == signals.end()) return false;
+	signal = it->second;
+	return true;
+}
+
+std::vector<scgms::UDevice_Event> recorded_stream(const std::string& path) {
+	std::ifstream f(path);
+	if (!f.is_open()) {
+		throw std::invalid_argument("error while opening file " + path);
+	}
+
+	std::vector<scgms::UDevice_Event> events;
+	std::set<uint64_t> segments;
+	double last_time = 0;
+
+	std::string line;
+	while (std::getline(f, line)) {
+		std::stringstream s(line);
+		std::string segment, time, name, level;
+		if (!std::getline(s, segment, ',') || !std::getline(s, time, ',') || !std::getline(s, name, ',') || !std::getline(s, level)) continue;
+
+		GUID signal;
+		if (!signal_by_name(name, signal)) continue; //header or unknown signal
+
+		const uint64_t seg_id = std::stoull(segment);
+		const double device_time = std::stod(time);
+		if (segments.insert(seg_id).second) {
+			events.push_back(make_event(scgms::NDevice_Event_Code::Time_Segment_Start, seg_id, device_time));
+		}
+		events.push_back(make_level(seg_id, device_time, signal, std::stod(level)));
+		last_time = std::max(last_time, device_time);
+	}
+
+	for (uint64_t seg_id : segments) {
+		events.push_back(make_event(scgms::NDevice_Event_Code::Time_Segment_Stop, seg_id, last_time));
+	}
+	events.push_back(make_event(scgms::NDevice_Event_Code::Shut_Down, 0, last_time));
+
+	return events;
+}
@@ -0,0 +1,19 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+
+#include <string>
+#include <vector>
+
+/*Recorded stream from csv with rows segment,device_time,signal,level
+ * Signal is one of ig, bg, carbs, pa, heartbeat, steps, acceleration, eda.
+ * Segment start/stop and shut down events are added by the loader.
+ */
+std::vector<scgms::UDevice_Event> recorded_stream(const std::string& path);
+
+/*Map of signal names used by recorded streams*/
+bool signal_by_name(const std::string& name, GUID& signal);
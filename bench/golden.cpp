@@ -0,0 +1,231 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "golden.h"
+
+#include "../src/descriptor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+	const char golden_magic[4] = { 'S', 'C', 'G', 'O' };
+	const uint32_t golden_version = 1;
+
+	/*Index of the ensemble configuration of the signal (0 is the signal itself), max_ensemble if it is not its output*/
+	size_t ensemble_index(const GUID& signal, const GUID& base) {
+		for (size_t k = 0; k < detection::max_ensemble; ++k) {
+			if (signal == detection::ensemble_signal(base, k)) return k;
+		}
+		return detection::max_ensemble;
+	}
+
+	std::string signal_name(const GUID& signal) {
+		if (signal == detection::signal_pa) return "pa";
+		if (signal == detection::signal_savgol) return "savgol";
+		if (signal == detection::signal_savgol_derivative) return "savgol derivative";
+
+		const size_t activation = ensemble_index(signal, detection::signal_activation);
+		if (activation == 0) return "activation";
+		if (activation < detection::max_ensemble) return "activation " + std::to_string(activation);
+
+		const size_t cho = ensemble_index(signal, detection::signal_cho);
+		if (cho == 0) return "cho";
+		if (cho < detection::max_ensemble) return "cho " + std::to_string(cho);
+
+		return "info";
+	}
+
+	/*Splits the text to numbers and the rest*/
+	bool next_token(const std::string& s, size_t& pos, std::string& text, double& number, bool& is_number) {
+		if (pos >= s.size()) return false;
+
+		const char* begin = s.c_str() + pos;
+		char* end = nullptr;
+		const bool numeric = std::isdigit(static_cast<unsigned char>(*begin)) || ((*begin == '-' || *begin == '.') && pos + 1 < s.size());
+		if (numeric) {
+			number = std::strtod(begin, &end);
+			if (end != begin) {
+				is_number = true;
+				pos += end - begin;
+				return true;
+			}
+		}
+
+		is_number = false;
+		text = *begin;
+		pos++;
+		return true;
+	}
+}
+
+CGolden_Filter::CGolden_Filter(scgms::IFilter* output, NMode mode, const std::string& path, TGolden_Tolerance tolerance)
+	: CBase_Filter(output), mMode(mode), mPath(path), mTolerance(tolerance) {
+
+	if (mode == NMode::Record) {
+		mOut.open(path, std::ios::binary);
+		mOut.write(golden_magic, sizeof(golden_magic));
+		mOut.write(reinterpret_cast<const char*>(&golden_version), sizeof(golden_version));
+		mFailed = !mOut.good();
+	}
+	else {
+		mIn.open(path, std::ios::binary);
+		char magic[sizeof(golden_magic)] = {};
+		uint32_t version = 0;
+		mIn.read(magic, sizeof(magic));
+		mIn.read(reinterpret_cast<char*>(&version), sizeof(version));
+		mFailed = !mIn.good() || std::memcmp(magic, golden_magic, sizeof(magic)) != 0 || version != golden_version;
+	}
+
+	if (mFailed) {
+		std::fprintf(stderr, "golden: cannot open %s\n", path.c_str());
+	}
+}
+
+CGolden_Filter::~CGolden_Filter() {
+	//
+}
+
+bool CGolden_Filter::is_golden(scgms::UDevice_Event& event) {
+	if (event.is_level_event()) {
+		const auto& s = event.signal_id();
+		return s == detection::signal_pa || s == detection::signal_savgol || s == detection::signal_savgol_derivative
+			|| ensemble_index(s, detection::signal_activation) < detection::max_ensemble || ensemble_index(s, detection::signal_cho) < detection::max_ensemble;
+	}
+
+	return event.is_info_event() && event.device_id() == detection::id_eval;
+}
+
+CGolden_Filter::TRecord CGolden_Filter::to_record(scgms::UDevice_Event& event) {
+	TRecord record;
+	record.code = static_cast<uint8_t>(event.event_code());
+	record.segment = event.segment_id();
+	record.device_time = event.device_time();
+	if (event.is_level_event()) {
+		record.signal = event.signal_id();
+		record.level = event.level();
+	}
+	else {
+		//information events are plain ASCII
+		const std::wstring info = event.info.get();
+		record.info.reserve(info.size());
+		for (wchar_t c : info) record.info.push_back(static_cast<char>(c));
+	}
+	return record;
+}
+
+void CGolden_Filter::write(const TRecord& record) {
+	const uint32_t length = static_cast<uint32_t>(record.info.size());
+	mOut.write(reinterpret_cast<const char*>(&record.code), sizeof(record.code));
+	mOut.write(reinterpret_cast<const char*>(&record.signal), sizeof(record.signal));
+	mOut.write(reinterpret_cast<const char*>(&record.segment), sizeof(record.segment));
+	mOut.write(reinterpret_cast<const char*>(&record.device_time), sizeof(record.device_time));
+	mOut.write(reinterpret_cast<const char*>(&record.level), sizeof(record.level));
+	mOut.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	mOut.write(record.info.data(), length);
+}
+
+bool CGolden_Filter::read(TRecord& record) {
+	uint32_t length = 0;
+	mIn.read(reinterpret_cast<char*>(&record.code), sizeof(record.code));
+	mIn.read(reinterpret_cast<char*>(&record.signal), sizeof(record.signal));
+	mIn.read(reinterpret_cast<char*>(&record.segment), sizeof(record.segment));
+	mIn.read(reinterpret_cast<char*>(&record.device_time), sizeof(record.device_time));
+	mIn.read(reinterpret_cast<char*>(&record.level), sizeof(record.level));
+	mIn.read(reinterpret_cast<char*>(&length), sizeof(length));
+	if (!mIn.good()) return false;
+
+	record.info.resize(length);
+	mIn.read(&record.info[0], length);
+	return mIn.good() || length == 0;
+}
+
+bool CGolden_Filter::equal(double a, double b) const {
+	if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+	if (a == b) return true;
+
+	const double diff = std::abs(a - b);
+	return diff <= std::max(mTolerance.absolute, mTolerance.relative * std::max(std::abs(a), std::abs(b)));
+}
+
+bool CGolden_Filter::equal(const std::string& a, const std::string& b) const {
+	size_t pos_a = 0, pos_b = 0;
+	std::string text_a, text_b;
+	double number_a = 0, number_b = 0;
+	bool numeric_a = false, numeric_b = false;
+
+	while (true) {
+		const bool has_a = next_token(a, pos_a, text_a, number_a, numeric_a);
+		const bool has_b = next_token(b, pos_b, text_b, number_b, numeric_b);
+		if (!has_a || !has_b) return has_a == has_b;
+		if (numeric_a != numeric_b) return false;
+		if (numeric_a ? !equal(number_a, number_b) : text_a != text_b) return false;
+	}
+}
+
+bool CGolden_Filter::equal(const TRecord& a, const TRecord& b) const {
+	return a.code == b.code && a.signal == b.signal && a.segment == b.segment
+		&& equal(a.device_time, b.device_time) && equal(a.level, b.level) && equal(a.info, b.info);
+}
+
+void CGolden_Filter::report(const TRecord* expected, const TRecord* actual) {
+	mDivergences++;
+	if (mDivergences > 1) return;
+
+	auto print = [](const char* label, const TRecord* r) {
+		if (!r) {
+			std::printf("  %-9s none\n", label);
+			return;
+		}
+		std::printf("  %-9s code %u, %s, segment %llu, device time %.10f", label, static_cast<unsigned>(r->code), signal_name(r->signal).c_str(),
+			static_cast<unsigned long long>(r->segment), r->device_time);
+		if (r->info.empty()) std::printf(", level %.17g\n", r->level);
+		else std::printf(", info \"%s\"\n", r->info.c_str());
+	};
+
+	std::printf("golden: first divergence at output event %zu\n", mIndex);
+	print("expected", expected);
+	print("actual", actual);
+}
+
+HRESULT IfaceCalling CGolden_Filter::Do_Execute(scgms::UDevice_Event event) {
+	if (!mFailed && is_golden(event)) {
+		const TRecord actual = to_record(event);
+		if (mMode == NMode::Record) {
+			write(actual);
+		}
+		else {
+			TRecord expected;
+			if (!read(expected)) {
+				report(nullptr, &actual);
+				mFailed = true;
+			}
+			else if (!equal(expected, actual)) {
+				report(&expected, &actual);
+			}
+		}
+		mIndex++;
+	}
+
+	return mOutput.Send(event);
+}
+
+bool CGolden_Filter::finish() {
+	if (mMode == NMode::Record) {
+		mOut.close();
+		return !mFailed && !mOut.fail();
+	}
+
+	//remaining recorded events are missing in the output
+	TRecord expected;
+	if (!mFailed && read(expected)) {
+		report(&expected, nullptr);
+	}
+
+	return !mFailed && mDivergences == 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+
+#include <fstream>
+#include <string>
+
+#pragma warning( push )
+#pragma warning( disable : 4250 ) // C4250 - 'class1' : inherits 'class2::member' via dominance
+
+/*Tolerance of the compared values, |a - b| <= max(absolute, relative * max(|a|, |b|))*/
+struct TGolden_Tolerance {
+	double absolute = 0.0;
+	double relative = 0.0;
+};
+
+/*Record or replay of the golden output stream
+ * Pass-through filter placed at the end of the chain. It records (or compares with the recording)
+ * the outputs of the detection filters - activation, signal_cho, signal_pa and signal_savgol levels
+ * and the information events of the evaluation. Numbers inside the information events are compared
+ * with the tolerance, the rest of the text exactly.
+ */
+class CGolden_Filter : public scgms::CBase_Filter {
+public:
+	enum class NMode { Record, Compare };
+
+	CGolden_Filter(scgms::IFilter* output, NMode mode, const std::string& path, TGolden_Tolerance tolerance = {});
+	virtual ~CGolden_Filter();
+
+	virtual HRESULT IfaceCalling QueryInterface(const GUID* /*riid*/, void** /*ppvObj*/) override final { return E_NOINTERFACE; }
+
+	/*Closes the recording, reports missing events of the comparison, returns false on divergence or error*/
+	bool finish();
+
+	size_t events() const { return mIndex; }
+	size_t divergences() const { return mDivergences; }
+
+protected:
+	virtual HRESULT Do_Execute(scgms::UDevice_Event event) override final;
+	virtual HRESULT Do_Configure(scgms::SFilter_Configuration /*configuration*/, refcnt::Swstr_list& /*error_description*/) override final { return S_OK; }
+
+private:
+	struct TRecord {
+		uint8_t code = 0;
+		GUID signal = Invalid_GUID;
+		uint64_t segment = 0;
+		double device_time = 0;
+		double level = 0;
+		std::string info;
+	};
+
+	NMode mMode;
+	std::string mPath;
+	TGolden_Tolerance mTolerance;
+	std::ofstream mOut;
+	std::ifstream mIn;
+	size_t mIndex = 0;
+	size_t mDivergences = 0;
+	bool mFailed = false;
+
+	static bool is_golden(scgms::UDevice_Event& event);
+	static TRecord to_record(scgms::UDevice_Event& event);
+
+	void write(const TRecord& record);
+	bool read(TRecord& record);
+
+	bool equal(double a, double b) const;
+	bool equal(const std::string& a, const std::string& b) const;
+	bool equal(const TRecord& a, const TRecord& b) const;
+
+	void report(const TRecord* expected, const TRecord* actual);
+};
+
+#pragma warning( pop )
@@ -0,0 +1,7 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include "../scgms_host.h"
@@ -0,0 +1,15 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include "../scgms_host.h"
+
+template <typename T, typename I, typename... Args>
+HRESULT Manufacture_Object(I** result, Args... args) {
+	T* obj = new T(args...);
+	obj->AddRef();
+	*result = static_cast<I*>(obj);
+	return S_OK;
+}
@@ -0,0 +1,101 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "scgms_host.h"
+
+#include <limits>
+#include <mutex>
+
+const wchar_t* dsParameters = L"Parameters";
+const wchar_t* rsParameters = L"Parameters";
+const wchar_t* dsmmol_per_L = L"mmol/L";
+
+namespace scgms {
+
+	namespace {
+		std::mutex factory_mutex;
+		std::vector<TDevice_Event*> free_events;
+		TEvent_Factory_Stats stats;
+	}
+
+	TDevice_Event* allocate_event() {
+		std::lock_guard<std::mutex> lock(factory_mutex);
+		stats.created++;
+		if (free_events.empty()) {
+			stats.allocated++;
+			return new TDevice_Event();
+		}
+
+		TDevice_Event* event = free_events.back();
+		free_events.pop_back();
+		*event = TDevice_Event();
+		return event;
+	}
+
+	void release_event(TDevice_Event* event) {
+		std::lock_guard<std::mutex> lock(factory_mutex);
+		stats.released++;
+		free_events.push_back(event);
+	}
+
+	TEvent_Factory_Stats event_factory_stats() {
+		std::lock_guard<std::mutex> lock(factory_mutex);
+		return stats;
+	}
+
+	void reset_event_factory_stats() {
+		std::lock_guard<std::mutex> lock(factory_mutex);
+		stats = TEvent_Factory_Stats();
+	}
+
+	const SFilter_Configuration::TValue* SFilter_Configuration::Find(const wchar_t* name) const {
+		auto it = mValues->find(name);
+		return it != mValues->end() ? &it->second : nullptr;
+	}
+
+	GUID SFilter_Configuration::Read_GUID(const wchar_t* name, const GUID& default_value) const {
+		auto value = Find(name);
+		return value && std::holds_alternative<GUID>(*value) ? std::get<GUID>(*value) : default_value;
+	}
+
+	int64_t SFilter_Configuration::Read_Int(const wchar_t* name, const int64_t default_value) const {
+		auto value = Find(name);
+		if (!value) return default_value;
+		if (std::holds_alternative<int64_t>(*value)) return std::get<int64_t>(*value);
+		if (std::holds_alternative<double>(*value)) return static_cast<int64_t>(std::get<double>(*value));
+		return default_value;
+	}
+
+	double SFilter_Configuration::Read_Double(const wchar_t* name, const double default_value) const {
+		auto value = Find(name);
+		if (!value) return default_value;
+		if (std::holds_alternative<double>(*value)) return std::get<double>(*value);
+		if (std::holds_alternative<int64_t>(*value)) return static_cast<double>(std::get<int64_t>(*value));
+		return default_value;
+	}
+
+	bool SFilter_Configuration::Read_Bool(const wchar_t* name, const bool default_value) const {
+		auto value = Find(name);
+		return value && std::holds_alternative<bool>(*value) ? std::get<bool>(*value) : default_value;
+	}
+
+	std::wstring SFilter_Configuration::Read_String(const wchar_t* name, const bool, const std::wstring& default_value) const {
+		auto value = Find(name);
+		return value && std::holds_alternative<std::wstring>(*value) ? std::get<std::wstring>(*value) : default_value;
+	}
+
+	filesystem::path SFilter_Configuration::Read_File_Path(const wchar_t* name) const {
+		return filesystem::path(Read_String(name));
+	}
+
+	bool SFilter_Configuration::Read_Parameters(const wchar_t* name, std::vector<double>& lower_bound, std::vector<double>& defaults, std::vector<double>& upper_bound) const {
+		auto value = Find(name);
+		if (!value || !std::holds_alternative<std::vector<double>>(*value)) return false;
+
+		defaults = std::get<std::vector<double>>(*value);
+		lower_bound = std::vector<double>(defaults.size(), -std::numeric_limits<double>::max());
+		upper_bound = std::vector<double>(defaults.size(), std::numeric_limits<double>::max());
+		return true;
+	}
+}
@@ -0,0 +1,350 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+/*
+ * Minimal stand-in for the SmartCGMS runtime used by the headless benchmark harness.
+ * Provides only the interface surface the detection filters use (events, filter
+ * configuration, filter base class and descriptors), so the filters can be built
+ * and driven in-process on any platform without scgms library, gpredict3 or console3.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "rtl/guid.h"
+
+using HRESULT = int32_t;
+using ULONG = uint32_t;
+
+constexpr HRESULT S_OK = 0;
+constexpr HRESULT S_FALSE = 1;
+constexpr HRESULT E_NOTIMPL = static_cast<HRESULT>(0x80004001);
+constexpr HRESULT E_NOINTERFACE = static_cast<HRESULT>(0x80004002);
+constexpr HRESULT E_FAIL = static_cast<HRESULT>(0x80004005);
+constexpr HRESULT E_OUTOFMEMORY = static_cast<HRESULT>(0x8007000E);
+constexpr HRESULT E_INVALIDARG = static_cast<HRESULT>(0x80070057);
+
+#define IfaceCalling
+
+static inline bool Succeeded(const HRESULT rc) { return rc >= 0; }
+
+namespace filesystem = std::filesystem;
+
+namespace refcnt {
+
+	class IReferenced {
+	public:
+		virtual ~IReferenced() = default;
+		virtual ULONG IfaceCalling AddRef() = 0;
+		virtual ULONG IfaceCalling Release() = 0;
+	};
+
+	class CReferenced : public virtual IReferenced {
+	public:
+		virtual ULONG IfaceCalling AddRef() override { return ++mCounter; }
+		virtual ULONG IfaceCalling Release() override {
+			const ULONG counter = --mCounter;
+			if (counter == 0) delete this;
+			return counter;
+		}
+	private:
+		std::atomic<ULONG> mCounter{ 0 };
+	};
+
+	class Swstr_list {
+	public:
+		void push(const wchar_t* str) { mItems.emplace_back(str); }
+		void push(const std::wstring& str) { mItems.push_back(str); }
+		const std::vector<std::wstring>& items() const { return mItems; }
+	private:
+		std::vector<std::wstring> mItems;
+	};
+}
+
+namespace scgms {
+
+	enum class NDevice_Event_Code : uint8_t {
+		Nothing = 0,
+		Level,
+		Masked_Level,
+		Parameters,
+		Parameters_Hint,
+		Suspend_Parameter_Solving,
+		Resume_Parameter_Solving,
+		Solve_Parameters,
+		Time_Segment_Start,
+		Time_Segment_Stop,
+		Warm_Reset,
+		Information,
+		Warning,
+		Error,
+		Shut_Down,
+		count
+	};
+
+	//device time is in days, as in SmartCGMS
+	constexpr double One_Day = 1.0;
+	constexpr double One_Hour = One_Day / 24.0;
+	constexpr double One_Minute = One_Hour / 60.0;
+	constexpr double One_Second = One_Minute / 60.0;
+
+	//stand-in signal identifiers, only their distinctness matters for the harness
+	constexpr GUID signal_Null = { 0x706e7fdb, 0x8f22, 0x486f, { 0xbf, 0xa5, 0x6a, 0x56, 0xd3, 0x51, 0x42, 0x09 } };
+	constexpr GUID signal_All = { 0xffffffff, 0xffff, 0xffff, { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+	constexpr GUID signal_BG = { 0xf666f6c2, 0xd7c0, 0x43e8, { 0x8e, 0xe1, 0xc8, 0xca, 0xa8, 0xf8, 0x60, 0xe5 } };
+	constexpr GUID signal_IG = { 0x3034568d, 0xf498, 0x455b, { 0xac, 0x6a, 0xbc, 0xf3, 0x01, 0xf6, 0x9c, 0x9e } };
+	constexpr GUID signal_Carb_Intake = { 0x37aa6ac1, 0x6984, 0x4a06, { 0x92, 0xcc, 0xa6, 0x60, 0x11, 0x0d, 0x0d, 0xc7 } };
+	constexpr GUID signal_Physical_Activity = { 0xf4438e9a, 0xdd52, 0x45bd, { 0x83, 0xce, 0x5e, 0x93, 0x61, 0x5e, 0x62, 0xbd } };
+	constexpr GUID signal_Heartbeat = { 0x6dfcfd02, 0xc48c, 0x4ce0, { 0xbd, 0x82, 0x2d, 0x94, 0x1e, 0x76, 0x7a, 0x99 } };
+	constexpr GUID signal_Steps = { 0xf5be9e4f, 0x8d8e, 0x4d1c, { 0x9a, 0x8a, 0x68, 0x9c, 0x1b, 0x6e, 0x6b, 0x43 } };
+	constexpr GUID signal_Acceleration = { 0xe57a3b4c, 0x9e2a, 0x4c41, { 0x8f, 0x0a, 0x3a, 0x8d, 0x2e, 0x1d, 0x93, 0x5b } };
+	constexpr GUID signal_Electrodermal_Activity = { 0xacff1b4a, 0x57a8, 0x4f8b, { 0x94, 0x3e, 0x07, 0xf5, 0xa1, 0x1c, 0x3e, 0x22 } };
+
+	struct TDevice_Event {
+		NDevice_Event_Code event_code = NDevice_Event_Code::Nothing;
+		GUID device_id = Invalid_GUID;
+		GUID signal_id = Invalid_GUID;
+		double device_time = 0.0;
+		int64_t logical_time = 0;
+		uint64_t segment_id = 0;
+		double level = 0.0;
+		std::wstring info;
+	};
+
+	/*Counters of the stand-in event factory*/
+	struct TEvent_Factory_Stats {
+		uint64_t created = 0;	//events constructed by UDevice_Event
+		uint64_t allocated = 0;	//events that needed new memory (not served from the free list)
+		uint64_t released = 0;	//events returned to the factory
+	};
+
+	/*Event factory - events are recycled through a free list*/
+	TDevice_Event* allocate_event();
+	void release_event(TDevice_Event* event);
+	TEvent_Factory_Stats event_factory_stats();
+	void reset_event_factory_stats();
+
+	/*Owning handle of the event, moved along the filter chain*/
+	class UDevice_Event {
+	public:
+		class CInfo {
+		public:
+			explicit CInfo(UDevice_Event* owner) : mOwner(owner) {}
+			void set(const wchar_t* str) { mOwner->mEvent->info = str; }
+			std::wstring get() const { return mOwner->mEvent ? mOwner->mEvent->info : std::wstring(); }
+		private:
+			UDevice_Event* mOwner;
+		};
+
+		UDevice_Event() : info(this) {}
+		explicit UDevice_Event(const NDevice_Event_Code code) : info(this), mEvent(allocate_event()) {
+			mEvent->event_code = code;
+		}
+		UDevice_Event(UDevice_Event&& other) noexcept : info(this), mEvent(other.mEvent) {
+			other.mEvent = nullptr;
+		}
+		UDevice_Event& operator=(UDevice_Event&& other) noexcept {
+			if (this != &other) {
+				reset();
+				mEvent = other.mEvent;
+				other.mEvent = nullptr;
+			}
+			return *this;
+		}
+		UDevice_Event(const UDevice_Event&) = delete;
+		UDevice_Event& operator=(const UDevice_Event&) = delete;
+		~UDevice_Event() { reset(); }
+
+		explicit operator bool() const { return mEvent != nullptr; }
+
+		NDevice_Event_Code& event_code() { return mEvent->event_code; }
+		GUID& device_id() { return mEvent->device_id; }
+		GUID& signal_id() { return mEvent->signal_id; }
+		double& device_time() { return mEvent->device_time; }
+		int64_t& logical_time() { return mEvent->logical_time; }
+		uint64_t& segment_id() { return mEvent->segment_id; }
+		double& level() { return mEvent->level; }
+
+		NDevice_Event_Code event_code() const { return mEvent->event_code; }
+		const GUID& signal_id() const { return mEvent->signal_id; }
+		double device_time() const { return mEvent->device_time; }
+		uint64_t segment_id() const { return mEvent->segment_id; }
+		double level() const { return mEvent->level; }
+
+		bool is_level_event() const { return mEvent->event_code == NDevice_Event_Code::Level; }
+		bool is_info_event() const { return mEvent->event_code == NDevice_Event_Code::Information || mEvent->event_code == NDevice_Event_Code::Warning || mEvent->event_code == NDevice_Event_Code::Error; }
+
+		void reset() {
+			if (mEvent) release_event(mEvent);
+			mEvent = nullptr;
+		}
+
+		CInfo info;
+
+	private:
+		TDevice_Event* mEvent = nullptr;
+	};
+
+	/*Configuration of a single filter, filled in by the harness*/
+	class SFilter_Configuration {
+	public:
+		using TValue = std::variant<bool, int64_t, double, GUID, std::wstring, std::vector<double>>;
+
+		SFilter_Configuration() : mValues(std::make_shared<std::map<std::wstring, TValue>>()) {}
+
+		void Set(const wchar_t* name, TValue value) { (*mValues)[name] = std::move(value); }
+
+		GUID Read_GUID(const wchar_t* name, const GUID& default_value = Invalid_GUID) const;
+		int64_t Read_Int(const wchar_t* name, const int64_t default_value = 0) const;
+		double Read_Double(const wchar_t* name, const double default_value = 0.0) const;
+		bool Read_Bool(const wchar_t* name, const bool default_value = false) const;
+		std::wstring Read_String(const wchar_t* name, const bool read_interpreted = true, const std::wstring& default_value = L"") const;
+		filesystem::path Read_File_Path(const wchar_t* name) const;
+		bool Read_Parameters(const wchar_t* name, std::vector<double>& lower_bound, std::vector<double>& defaults, std::vector<double>& upper_bound) const;
+
+	private:
+		std::shared_ptr<std::map<std::wstring, TValue>> mValues;
+
+		const TValue* Find(const wchar_t* name) const;
+	};
+
+	class IFilter : public virtual refcnt::IReferenced {
+	public:
+		virtual HRESULT IfaceCalling QueryInterface(const GUID* riid, void** ppvObj) = 0;
+		virtual HRESULT IfaceCalling Configure(SFilter_Configuration configuration, refcnt::Swstr_list& error_description) = 0;
+		virtual HRESULT IfaceCalling Execute(UDevice_Event event) = 0;
+	};
+
+	/*Output of the filter*/
+	class SFilter {
+	public:
+		explicit SFilter(IFilter* filter) : mFilter(filter) {}
+
+		HRESULT Send(UDevice_Event& event) {
+			if (!mFilter) {
+				event.reset();
+				return S_OK;
+			}
+			return mFilter->Execute(std::move(event));
+		}
+
+	private:
+		IFilter* mFilter;
+	};
+
+	class CBase_Filter : public virtual IFilter, public virtual refcnt::CReferenced {
+	protected:
+		SFilter mOutput;
+
+		virtual HRESULT Do_Execute(UDevice_Event event) = 0;
+		virtual HRESULT Do_Configure(SFilter_Configuration configuration, refcnt::Swstr_list& error_description) = 0;
+
+		template <typename I>
+		bool Internal_Query_Interface(const GUID& id, const GUID& riid, void** ppvObj) {
+			if (id != riid) return false;
+			*ppvObj = static_cast<I*>(this);
+			AddRef();
+			return true;
+		}
+
+	public:
+		explicit CBase_Filter(IFilter* output) : mOutput(output) {}
+		virtual ~CBase_Filter() = default;
+
+		virtual HRESULT IfaceCalling Configure(SFilter_Configuration configuration, refcnt::Swstr_list& error_description) override {
+			return Do_Configure(configuration, error_description);
+		}
+
+		virtual HRESULT IfaceCalling Execute(UDevice_Event event) override {
+			return Do_Execute(std::move(event));
+		}
+	};
+
+	//descriptors
+	enum class NFilter_Flags : uint8_t { None = 0 };
+	enum class NModel_Flags : uint8_t { None = 0 };
+
+	enum class NParameter_Type : uint8_t {
+		ptNull = 0,
+		ptWChar_Array,
+		ptInt64,
+		ptDouble,
+		ptRatTime,
+		ptBool,
+		ptSignal_Model_Id,
+		ptDiscrete_Model_Id,
+		ptMetric_Id,
+		ptSolver_Id,
+		ptModel_Produced_Signal_Id,
+		ptSignal_Id,
+		ptDouble_Array,
+		ptSubject_Id
+	};
+
+	enum class NModel_Parameter_Value : uint8_t { mptDouble = 0, mptTime, mptBool };
+	enum class NSignal_Unit : uint8_t { Other = 0, Unitless, Percent, mmol_per_L, mg_per_dl };
+	enum class NSignal_Visualization : uint8_t { smooth = 0, step, mark };
+	enum class NSignal_Mark : uint8_t { none = 0, cross, circle };
+
+	struct TFilter_Descriptor {
+		const GUID id;
+		const NFilter_Flags flags;
+		const wchar_t* description;
+		const size_t parameters_count;
+		const NParameter_Type* parameter_type;
+		const wchar_t** ui_parameter_name;
+		const wchar_t** config_parameter_name;
+		const wchar_t** ui_parameter_tooltip;
+	};
+
+	struct TModel_Descriptor {
+		const GUID id;
+		const NModel_Flags flags;
+		const wchar_t* description;
+		const wchar_t* db_table_name;
+		const size_t total_number_of_parameters;
+		const NModel_Parameter_Value* parameter_types;
+		const wchar_t** parameter_ui_names;
+		const wchar_t** parameter_db_column_names;
+		const double* lower_bound;
+		const double* default_values;
+		const double* upper_bound;
+		const size_t number_of_calculated_signals;
+		const GUID* calculated_signal_ids;
+		const GUID* reference_signal_ids;
+	};
+
+	struct TSignal_Descriptor {
+		const GUID id;
+		const wchar_t* signal_description;
+		const wchar_t* unit_description;
+		const NSignal_Unit unit;
+		const uint32_t fill_color;
+		const uint32_t stroke_color;
+		const NSignal_Visualization visualization;
+		const NSignal_Mark mark;
+		const void* reserved;
+	};
+}
+
+extern const wchar_t* dsParameters;
+extern const wchar_t* rsParameters;
+extern const wchar_t* dsmmol_per_L;
+
+/*Filter library entry points implemented by descriptor.cpp*/
+extern "C" HRESULT IfaceCalling do_get_filter_descriptors(scgms::TFilter_Descriptor** begin, scgms::TFilter_Descriptor** end);
+extern "C" HRESULT IfaceCalling do_get_signal_descriptors(scgms::TSignal_Descriptor** begin, scgms::TSignal_Descriptor** end);
+extern "C" HRESULT IfaceCalling do_get_model_descriptors(scgms::TModel_Descriptor** begin, scgms::TModel_Descriptor** end);
+extern "C" HRESULT IfaceCalling do_create_filter(const GUID* id, scgms::IFilter* output, scgms::IFilter** filter);
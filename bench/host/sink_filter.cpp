@@ -0,0 +1,21 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "sink_filter.h"
+
+HRESULT IfaceCalling CSink_Filter::Execute(scgms::UDevice_Event event) {
+	mCount++;
+	if (event.is_level_event()) {
+		mLevel_Counts[event.signal_id()]++;
+	}
+	else if (event.is_info_event()) {
+		mInfos.push_back(event.info.get());
+	}
+
+	if (mCapture) {
+		mEvents.push_back(std::move(event));
+	}
+
+	return S_OK;
+}
@@ -0,0 +1,36 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include "scgms_host.h"
+
+#pragma warning( push )
+#pragma warning( disable : 4250 ) // C4250 - 'class1' : inherits 'class2::member' via dominance
+
+/*Terminal filter of the benchmarked chain - counts the events and optionally keeps them for the next stage*/
+class CSink_Filter : public virtual scgms::IFilter, public virtual refcnt::CReferenced {
+public:
+	explicit CSink_Filter(bool capture = false) : mCapture(capture) {}
+
+	virtual HRESULT IfaceCalling QueryInterface(const GUID* /*riid*/, void** /*ppvObj*/) override final { return E_NOINTERFACE; }
+	virtual HRESULT IfaceCalling Configure(scgms::SFilter_Configuration /*configuration*/, refcnt::Swstr_list& /*error_description*/) override final { return S_OK; }
+	virtual HRESULT IfaceCalling Execute(scgms::UDevice_Event event) override final;
+
+	size_t count() const { return mCount; }
+	const std::map<GUID, size_t>& level_counts() const { return mLevel_Counts; }
+	const std::vector<std::wstring>& infos() const { return mInfos; }
+
+	/*Captured events, moved out of the sink*/
+	std::vector<scgms::UDevice_Event> take_events() { return std::move(mEvents); }
+
+private:
+	bool mCapture;
+	size_t mCount = 0;
+	std::map<GUID, size_t> mLevel_Counts;
+	std::vector<std::wstring> mInfos;
+	std::vector<scgms::UDevice_Event> mEvents;
+};
+
+#pragma warning( pop )
@@ -0,0 +1,16 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include "../scgms_host.h"
+
+#include <array>
+
+template <typename T, size_t N>
+HRESULT do_get_descriptors(const std::array<T, N>& descriptors, T** begin, T** end) {
+	*begin = const_cast<T*>(descriptors.data());
+	*end = *begin + N;
+	return S_OK;
+}
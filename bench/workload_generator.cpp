@@ -0,0 +1,224 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	const double start_time = 43831.0; //2020-01-01 as rat time
+	const double pi = 3.14159265358979323846;
+
+	uint64_t splitmix64(uint64_t x) {
+		x += 0x9e3779b97f4a7c15ULL;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+	/*Glucose response to carbohydrates [mmol/L], peak 1 hour after the meal*/
+	double meal_response(double carbs, double hours) {
+		return hours > 0 ? carbs / 12.0 * hours * std::exp(1.0 - hours) : 0.0;
+	}
+}
+
+uint64_t CWorkload_Generator::TRandom::next() {
+	state += 0x9e3779b97f4a7c15ULL;
+	return splitmix64(state);
+}
+
+double CWorkload_Generator::TRandom::uniform(double min, double max) {
+	return min + (max - min) * ((next() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+double CWorkload_Generator::TRandom::normal(double mean, double sd) {
+	//Box-Muller
+	const double u1 = std::max(uniform(), 1e-300);
+	const double u2 = uniform();
+	return mean + sd * std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * pi * u2);
+}
+
+CWorkload_Generator::CWorkload_Generator(const TWorkload_Params& params) : mParams(params) {
+	mSteps = static_cast<size_t>(params.days / params.step);
+	mSegments.resize(params.segments);
+	for (size_t i = 0; i < mSegments.size(); ++i) {
+		auto& seg = mSegments[i];
+		seg.rng.state = splitmix64(params.seed ^ splitmix64(i + 1));
+		seg.baseline = seg.rng.uniform(5.0, 7.5);
+		seg.ig = seg.baseline;
+		seg.rest_hr = seg.rng.uniform(58, 78);
+		seg.eda = seg.rng.uniform(1, 4);
+	}
+}
+
+bool CWorkload_Generator::next(scgms::UDevice_Event& event) {
+	while (mPending_Pos == mPending.size()) {
+		if (mPhase == NPhase::Done) return false;
+		mPending.clear();
+		mPending_Pos = 0;
+		fill();
+	}
+
+	event = std::move(mPending[mPending_Pos++]);
+	mGenerated++;
+	return true;
+}
+
+void CWorkload_Generator::fill() {
+	const double end_time = start_time + mSteps * mParams.step;
+
+	switch (mPhase) {
+		case NPhase::Start:
+			for (uint64_t s = 1; s <= mSegments.size(); ++s) {
+				push(scgms::NDevice_Event_Code::Time_Segment_Start, s, start_time);
+			}
+			mPhase = mSteps > 0 ? NPhase::Level : NPhase::Stop;
+			break;
+
+		case NPhase::Level: {
+			const double time = start_time + mStep * mParams.step;
+			for (uint64_t s = 1; s <= mSegments.size(); ++s) {
+				generate_step(s, mSegments[s - 1], time);
+			}
+			//high-rate accelerometer - further samples evenly spaced until the next step, in time order across the segments
+			for (size_t i = 1; mParams.acceleration && i < mParams.acceleration_rate; ++i) {
+				const double sample_time = time + i * mParams.step / mParams.acceleration_rate;
+				for (uint64_t s = 1; s <= mSegments.size(); ++s) {
+					generate_acceleration(s, mSegments[s - 1], time, sample_time);
+				}
+			}
+			if (++mStep == mSteps) mPhase = NPhase::Stop;
+			break;
+		}
+
+		case NPhase::Stop:
+			for (uint64_t s = 1; s <= mSegments.size(); ++s) {
+				push(scgms::NDevice_Event_Code::Time_Segment_Stop, s, end_time);
+			}
+			push(scgms::NDevice_Event_Code::Shut_Down, 0, end_time);
+			mPhase = NPhase::Done;
+			break;
+
+		case NPhase::Done:
+			break;
+	}
+}
+
+void CWorkload_Generator::plan_day(TSegment& seg, double day_start) {
+	auto& rng = seg.rng;
+	seg.plan = {};
+
+	//breakfast, lunch, snack, dinner
+	if (rng.chance(0.9)) seg.plan[0] = { day_start + rng.normal(7.0, 0.75) * scgms::One_Hour, rng.uniform(20, 60) };
+	if (rng.chance(0.95)) seg.plan[1] = { day_start + rng.normal(12.5, 1.0) * scgms::One_Hour, rng.uniform(40, 90) };
+	if (rng.chance(0.3)) seg.plan[2] = { day_start + rng.normal(15.5, 1.0) * scgms::One_Hour, rng.uniform(10, 30) };
+	if (rng.chance(0.95)) seg.plan[3] = { day_start + rng.normal(18.5, 1.0) * scgms::One_Hour, rng.uniform(40, 100) };
+
+	if (rng.chance(0.5)) {
+		seg.exercise_start = day_start + rng.uniform(16, 19.5) * scgms::One_Hour;
+		seg.exercise_end = seg.exercise_start + rng.uniform(30, 90) * scgms::One_Minute;
+		seg.intensity = rng.uniform(0.5, 1.0);
+	}
+
+	if (rng.chance(mParams.gap_probability)) {
+		seg.gap_start = day_start + rng.uniform(0, 1) * scgms::One_Day;
+		seg.gap_end = seg.gap_start + rng.uniform(30, 180) * scgms::One_Minute;
+	}
+}
+
+void CWorkload_Generator::generate_step(uint64_t seg_id, TSegment& seg, double time) {
+	const double step = mParams.step;
+	const double day_start = std::floor(time);
+	const double day_time = time - day_start;
+	auto& rng = seg.rng;
+
+	const auto day = static_cast<int64_t>(day_start);
+	if (day != seg.day) {
+		seg.day = day;
+		plan_day(seg, day_start);
+	}
+
+	//meals
+	for (auto& meal : seg.plan) {
+		if (meal.time > time - step && meal.time <= time) {
+			if (mParams.bg) {
+				push_level(seg_id, time, scgms::signal_BG, seg.ig * (1 + rng.normal(0, 0.05)));
+			}
+			push_level(seg_id, time, scgms::signal_Carb_Intake, meal.carbs);
+
+			//replace the oldest meal
+			auto oldest = std::min_element(seg.meals.begin(), seg.meals.end(), [](const TMeal& a, const TMeal& b) { return a.time < b.time; });
+			*oldest = { time, meal.carbs };
+		}
+	}
+
+	//exercise
+	const bool exercise = time >= seg.exercise_start && time < seg.exercise_end;
+	if (seg.exercise_start > time - step && seg.exercise_start <= time) {
+		push_level(seg_id, time, scgms::signal_Physical_Activity, seg.intensity);
+	}
+	if (seg.exercise_end > time - step && seg.exercise_end <= time) {
+		push_level(seg_id, time, scgms::signal_Physical_Activity, 0.0);
+	}
+
+	//blood glucose - baseline with slow drift, meal responses and the effect of the exercise
+	seg.drift += -0.02 * seg.drift + rng.normal(0, 0.03);
+	double bg = seg.baseline + seg.drift;
+	for (const auto& meal : seg.meals) {
+		if (meal.carbs > 0) bg += meal_response(meal.carbs, (time - meal.time) / scgms::One_Hour);
+	}
+	if (exercise) {
+		bg -= 1.5 * seg.intensity * std::min(1.0, (time - seg.exercise_start) / (30 * scgms::One_Minute));
+	}
+	bg = std::max(bg, 2.2);
+
+	//interstitial glucose follows the blood glucose with a delay
+	seg.ig += (bg - seg.ig) * std::min(1.0, step / (10 * scgms::One_Minute));
+	if (time < seg.gap_start || time >= seg.gap_end) {
+		push_level(seg_id, time, scgms::signal_IG, seg.ig + rng.normal(0, mParams.noise));
+	}
+
+	//wearables are not affected by the CGM gaps
+	const bool awake = day_time > 7 * scgms::One_Hour && day_time < 22.5 * scgms::One_Hour;
+	const double intensity = exercise ? seg.intensity : 0.0;
+	if (mParams.heartbeat) {
+		push_level(seg_id, time, scgms::signal_Heartbeat, seg.rest_hr + (awake ? 8 : 0) + 60 * intensity + rng.normal(0, 3));
+	}
+	if (mParams.steps) {
+		const double steps = exercise ? 500 + 300 * intensity : (awake ? rng.uniform(0, 80) : 0);
+		push_level(seg_id, time, scgms::signal_Steps, std::round(steps));
+	}
+	if (mParams.acceleration) {
+		push_level(seg_id, time, scgms::signal_Acceleration, 1.0 + 0.8 * intensity + std::abs(rng.normal(0, awake ? 0.05 : 0.01)));
+	}
+	if (mParams.eda) {
+		seg.eda += 0.1 * ((exercise ? 6.0 : 2.5) - seg.eda) + rng.normal(0, 0.05);
+		push_level(seg_id, time, scgms::signal_Electrodermal_Activity, std::max(seg.eda, 0.0));
+	}
+}
+
+void CWorkload_Generator::generate_acceleration(uint64_t seg_id, TSegment& seg, double time, double sample_time) {
+	const double day_time = time - std::floor(time);
+	const bool awake = day_time > 7 * scgms::One_Hour && day_time < 22.5 * scgms::One_Hour;
+	const bool exercise = time >= seg.exercise_start && time < seg.exercise_end;
+	const double intensity = exercise ? seg.intensity : 0.0;
+	push_level(seg_id, sample_time, scgms::signal_Acceleration, 1.0 + 0.8 * intensity + std::abs(seg.rng.normal(0, awake ? 0.05 : 0.01)));
+}
+
+void CWorkload_Generator::push(scgms::NDevice_Event_Code code, uint64_t segment, double time) {
+	scgms::UDevice_Event event(code);
+	event.segment_id() = segment;
+	event.device_time() = time;
+	mPending.push_back(std::move(event));
+}
+
+void CWorkload_Generator::push_level(uint64_t segment, double time, const GUID& signal, double level) {
+	scgms::UDevice_Event event(scgms::NDevice_Event_Code::Level);
+	event.segment_id() = segment;
+	event.device_time() = time;
+	event.signal_id() = signal;
+	event.level() = level;
+	mPending.push_back(std::move(event));
+}
@@ -0,0 +1,95 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+
+#include <array>
+#include <vector>
+
+/*Parameters of the synthetic workload*/
+struct TWorkload_Params {
+	size_t segments = 100;
+	double days = 7;
+	uint32_t seed = 42;
+	double step = 5 * scgms::One_Minute;
+	double noise = 0.15; //sensor noise of IG [mmol/L]
+	double gap_probability = 0.1; //probability of a sensor gap per segment and day
+	bool bg = true;
+	bool heartbeat = true;
+	bool steps = true;
+	bool acceleration = true;
+	size_t acceleration_rate = 1; //acceleration samples per step
+	bool eda = true;
+};
+
+/*Deterministic synthetic CGM and wearable workload
+ * Segments are interleaved in device time as in a live multi-patient stream. Events are
+ * generated one sampling step at a time, memory is proportional to the number of segments.
+ * Every segment has its own random stream derived from the seed, so the segment data do
+ * not depend on the number of generated segments.
+ * Meals are sent as signal_Carb_Intake and exercise as signal_Physical_Activity (intensity
+ * at the start, 0 at the end) - ground truth for the evaluation and the online learning.
+ */
+class CWorkload_Generator {
+public:
+	explicit CWorkload_Generator(const TWorkload_Params& params);
+
+	/*Next event of the stream, false at the end*/
+	bool next(scgms::UDevice_Event& event);
+
+	size_t generated() const { return mGenerated; }
+
+private:
+	/*Small random generator, the state is kept per segment*/
+	struct TRandom {
+		uint64_t state;
+		uint64_t next();
+		double uniform(double min = 0.0, double max = 1.0);
+		double normal(double mean = 0.0, double sd = 1.0);
+		bool chance(double p) { return uniform() < p; }
+	};
+
+	struct TMeal {
+		double time = 0;
+		double carbs = 0;
+	};
+
+	struct TSegment {
+		TRandom rng;
+		double baseline = 6.0;
+		double drift = 0;
+		double ig = 0;
+		double rest_hr = 70;
+		double eda = 2;
+		int64_t day = -1;
+		std::array<TMeal, 4> plan; //meals of the current day, time 0 = no meal
+		std::array<TMeal, 4> meals; //meals affecting the glucose
+		double exercise_start = 0;
+		double exercise_end = 0;
+		double intensity = 0;
+		double gap_start = 0;
+		double gap_end = 0;
+	};
+
+	enum class NPhase { Start, Level, Stop, Done };
+
+	TWorkload_Params mParams;
+	std::vector<TSegment> mSegments;
+	std::vector<scgms::UDevice_Event> mPending;
+	size_t mPending_Pos = 0;
+	NPhase mPhase = NPhase::Start;
+	size_t mStep = 0;
+	size_t mSteps = 0;
+	size_t mGenerated = 0;
+
+	void plan_day(TSegment& seg, double day_start);
+	void generate_step(uint64_t seg_id, TSegment& seg, double time);
+	/*Further acceleration sample of the step (time) at the sample time between the steps*/
+	void generate_acceleration(uint64_t seg_id, TSegment& seg, double time, double sample_time);
+	void push(scgms::NDevice_Event_Code code, uint64_t segment, double time);
+	void push_level(uint64_t segment, double time, const GUID& signal, double level);
+	void fill();
+};
@@ -0,0 +1,164 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "csv_reader.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+	inline const char* skip_spaces(const char* p, const char* end) {
+		while (p < end && (*p == ' ' || *p == '\t')) ++p;
+		return p;
+	}
+
+	/*Number with optional leading + (accepted by stod)*/
+	inline std::from_chars_result parse_number(const char* p, const char* end, double& value) {
+		if (p < end && *p == '+') ++p;
+		return std::from_chars(p, end, value);
+	}
+
+	/*Number of lines before p*/
+	inline size_t lines_before(const char* begin, const char* p) {
+		return static_cast<size_t>(std::count(begin, p, '\n'));
+	}
+}
+
+csv_data csv_reader::read(const std::string& path, size_t n_threads)
+{
+	mapped_file file(path);
+	const char* begin = file.data();
+	const char* end = begin + file.size();
+
+	if (n_threads == 0) {
+		n_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+	n_threads = std::max<size_t>(1, std::min(n_threads, file.size() / min_chunk));
+
+	//split to chunks on line boundaries
+	std::vector<const char*> bounds = { begin };
+	for (size_t i = 1; i < n_threads; ++i) {
+		const char* p = std::max(begin + file.size() * i / n_threads, bounds.back());
+		p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		if (!p) break;
+		bounds.push_back(p + 1);
+	}
+	bounds.push_back(end);
+
+	const size_t n_chunks = bounds.size() - 1;
+	std::vector<csv_data> chunks(n_chunks);
+	std::vector<size_t> first_lines(n_chunks, 0);
+	std::vector<size_t> error_lines(n_chunks, 0);
+	std::vector<std::string> errors(n_chunks);
+
+	if (n_chunks == 1) {
+		parse(bounds[0], bounds[1], chunks[0], first_lines[0], error_lines[0], errors[0]);
+	}
+	else {
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < n_chunks; ++i) {
+			workers.emplace_back(&csv_reader::parse, bounds[i], bounds[i + 1], std::ref(chunks[i]), std::ref(first_lines[i]), std::ref(error_lines[i]), std::ref(errors[i]));
+		}
+		for (auto& w : workers) w.join();
+	}
+
+	//merge chunks and validate column count across them, lines of the chunk are counted only for the error
+	csv_data data;
+	size_t rows = 0;
+	for (size_t i = 0; i < n_chunks; ++i) {
+		if (!errors[i].empty()) {
+			const size_t line = lines_before(begin, bounds[i]) + error_lines[i] + 1;
+			throw std::invalid_argument(path + ", line " + std::to_string(line) + ": " + errors[i]);
+		}
+		if (chunks[i].rows() == 0) continue;
+		if (data.cols == 0) {
+			data.cols = chunks[i].cols;
+		}
+		else if (chunks[i].cols != data.cols) {
+			const size_t line = lines_before(begin, bounds[i]) + first_lines[i] + 1;
+			throw std::invalid_argument(path + ", line " + std::to_string(line) + ": expected " + std::to_string(data.cols) + " columns");
+		}
+		rows += chunks[i].rows();
+	}
+
+	data.values.reserve(rows * data.cols);
+	data.labels.reserve(rows);
+	for (auto& chunk : chunks) {
+		data.values.insert(data.values.end(), chunk.values.begin(), chunk.values.end());
+		data.labels.insert(data.labels.end(), chunk.labels.begin(), chunk.labels.end());
+	}
+
+	return data;
+}
+
+void csv_reader::parse(const char* begin, const char* end, csv_data& data, size_t& first_line, size_t& error_line, std::string& error)
+{
+	const char* p = begin;
+	for (size_t line = 0; p < end; ++line) {
+		const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		if (!eol) eol = end;
+		const char* line_end = (eol > p && *(eol - 1) == '\r') ? eol - 1 : eol;
+
+		//skip empty lines
+		if (skip_spaces(p, line_end) == line_end) {
+			p = eol + 1;
+			continue;
+		}
+		if (data.labels.empty()) {
+			first_line = line;
+		}
+
+		//first column is label, integral number (1 or 1.0)
+		double label = 0;
+		auto res = parse_number(skip_spaces(p, line_end), line_end, label);
+		if (res.ec != std::errc() || label < 0 || label != std::floor(label)) {
+			error_line = line;
+			error = "invalid label";
+			return;
+		}
+
+		size_t cols = 0;
+		const char* q = skip_spaces(res.ptr, line_end);
+		while (q < line_end) {
+			if (*q != ',') {
+				error_line = line;
+				error = "unexpected character";
+				return;
+			}
+			//trailing comma
+			const char* value_begin = skip_spaces(q + 1, line_end);
+			if (value_begin == line_end) {
+				break;
+			}
+			double value = 0;
+			res = parse_number(value_begin, line_end, value);
+			if (res.ec != std::errc()) {
+				error_line = line;
+				error = "invalid number in column " + std::to_string(cols + 2);
+				return;
+			}
+			data.values.push_back(value);
+			++cols;
+			q = skip_spaces(res.ptr, line_end);
+		}
+
+		if (data.labels.empty()) {
+			data.cols = cols;
+		}
+		else if (cols != data.cols) {
+			data.values.resize(data.labels.size() * data.cols);
+			error_line = line;
+			error = "expected " + std::to_string(data.cols) + " columns, found " + std::to_string(cols);
+			return;
+		}
+		data.labels.push_back(static_cast<unsigned long>(label));
+
+		p = eol + 1;
+	}
+}
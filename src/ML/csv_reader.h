@@ -0,0 +1,46 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+* Labelled data in contiguous row-major matrix
+*/
+struct csv_data
+{
+	size_t cols = 0;
+	std::vector<double> values;
+	std::vector<unsigned long> labels;
+
+	size_t rows() const { return labels.size(); }
+	const double* row(size_t i) const { return values.data() + i * cols; }
+};
+
+/**
+* Fast loader of csv files with label in the first column followed by numeric features.
+* The file is memory mapped and parsed in parallel by chunks split on line boundaries.
+* Label may be written as a number with a zero fraction (1.0), numbers may have a leading +,
+* a trailing comma at the end of the line is ignored, blank lines are skipped.
+*/
+class csv_reader
+{
+public:
+	/*Load csv, n_threads = 0 uses all hardware threads
+	 * Throws std::invalid_argument if the file cannot be read, contains invalid number or rows differ in column count,
+	 * the message contains the line number in the file (blank lines included).
+	 */
+	static csv_data read(const std::string& path, size_t n_threads = 0);
+
+private:
+	/*Minimal chunk size to be parsed by separate thread*/
+	static constexpr size_t min_chunk = 1 << 20;
+
+	/*Parse lines in [begin, end), error holds message of the first invalid line
+	 * first_line and error_line are indices of lines within the chunk (blank lines included).
+	 */
+	static void parse(const char* begin, const char* end, csv_data& data, size_t& first_line, size_t& error_line, std::string& error);
+};
@@ -0,0 +1,290 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "dataset.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+static_assert(sizeof(dataset_header) == 40, "dataset header must be packed");
+
+namespace {
+	bool little_endian() {
+		const uint16_t one = 1;
+		unsigned char first = 0;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	uint32_t swap_bytes(uint32_t value) {
+		return ((value & 0xFFu) << 24) | ((value & 0xFF00u) << 8) | ((value >> 8) & 0xFF00u) | (value >> 24);
+	}
+
+	uint64_t swap_bytes(uint64_t value) {
+		return (static_cast<uint64_t>(swap_bytes(static_cast<uint32_t>(value))) << 32) | swap_bytes(static_cast<uint32_t>(value >> 32));
+	}
+
+	/*Converts the header between the host and the file byte order (the conversion is symmetric)*/
+	dataset_header convert(dataset_header header) {
+		if (!little_endian()) {
+			header.version = swap_bytes(header.version);
+			header.feature_type = swap_bytes(header.feature_type);
+			header.label_type = swap_bytes(header.label_type);
+			header.rows = swap_bytes(header.rows);
+			header.cols = swap_bytes(header.cols);
+			header.block_rows = swap_bytes(header.block_rows);
+		}
+		return header;
+	}
+
+	/*Writes 8-byte values little-endian*/
+	template <class T>
+	void write_values(std::ostream& f, const T* values, size_t count) {
+		static_assert(sizeof(T) == sizeof(uint64_t), "values must have 8 bytes");
+		if (little_endian()) {
+			f.write(reinterpret_cast<const char*>(values), count * sizeof(T));
+			return;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			uint64_t value;
+			std::memcpy(&value, values + i, sizeof(value));
+			value = swap_bytes(value);
+			f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+	}
+
+	/*Reads 8-byte values stored little-endian*/
+	template <class T>
+	void read_values(std::istream& f, T* values, size_t count) {
+		static_assert(sizeof(T) == sizeof(uint64_t), "values must have 8 bytes");
+		f.read(reinterpret_cast<char*>(values), count * sizeof(T));
+		if (!little_endian()) {
+			for (size_t i = 0; i < count; ++i) {
+				uint64_t value;
+				std::memcpy(&value, values + i, sizeof(value));
+				value = swap_bytes(value);
+				std::memcpy(values + i, &value, sizeof(value));
+			}
+		}
+	}
+
+	bool supported(const dataset_header& header) {
+		return std::memcmp(header.magic, dataset_header::magic_value, sizeof(header.magic)) == 0
+			&& header.version == dataset_header::current_version
+			&& header.feature_type == dataset_header::type_float64
+			&& header.label_type == dataset_header::type_uint64
+			&& header.block_rows > 0;
+	}
+
+	/*Size of the file with the given number of blocks, false on overflow*/
+	bool dataset_size(const dataset_header& header, uint64_t file_size, uint64_t& size) {
+		const uint64_t blocks = header.rows / header.block_rows + (header.rows % header.block_rows != 0);
+		if (blocks == 0) {
+			size = sizeof(dataset_header);
+			return true;
+		}
+		const uint64_t values = file_size / sizeof(double);
+		if (header.cols + 1 > values / header.block_rows) return false;
+		const uint64_t block_values = header.block_rows * (header.cols + 1);
+		if (blocks > values / block_values) return false;
+		size = sizeof(dataset_header) + blocks * block_values * sizeof(double);
+		return true;
+	}
+}
+
+dataset_writer::dataset_writer(const std::string& path, size_t cols, bool append, size_t block_rows) : path(path), columns(cols), block_rows(std::max<size_t>(block_rows, 1))
+{
+	std::error_code ec;
+	if (append && std::filesystem::is_regular_file(path, ec) && std::filesystem::file_size(path, ec) > 0) {
+		std::ifstream f(path, std::ios::binary);
+		dataset_header header;
+		f.read(reinterpret_cast<char*>(&header), sizeof(header));
+		header = convert(header);
+		uint64_t size = 0;
+		if (!f || !supported(header) || header.cols != cols || !dataset_size(header, std::filesystem::file_size(path, ec), size) || std::filesystem::file_size(path, ec) < size) {
+			throw std::invalid_argument("incompatible dataset " + path);
+		}
+
+		this->block_rows = static_cast<size_t>(header.block_rows);
+		total_rows = header.rows;
+		block.resize(this->block_rows * columns);
+		block_labels.resize(this->block_rows);
+
+		//continue the last partial block
+		block_count = static_cast<size_t>(total_rows % this->block_rows);
+		if (block_count > 0) {
+			f.seekg(sizeof(dataset_header) + (total_rows / this->block_rows) * this->block_rows * (columns + 1) * sizeof(double));
+			read_values(f, block.data(), block.size());
+			read_values(f, block_labels.data(), block_labels.size());
+			if (!f) {
+				throw std::invalid_argument("truncated dataset " + path);
+			}
+		}
+		f.close();
+
+		file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+		if (!file.is_open()) {
+			throw std::runtime_error("error while opening file " + path);
+		}
+		return;
+	}
+
+	block.resize(this->block_rows * columns);
+	block_labels.resize(this->block_rows);
+
+	file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("error while opening file " + path);
+	}
+	write_header();
+	if (!file) {
+		throw std::runtime_error("error while writing file " + path);
+	}
+}
+
+dataset_writer::~dataset_writer()
+{
+	try {
+		close();
+	}
+	catch (...) {
+		//destructor must not throw, call close explicitly to get errors
+	}
+}
+
+void dataset_writer::push_back(const std::vector<double>& row, uint64_t label)
+{
+	if (row.size() != columns) {
+		throw std::invalid_argument("expected " + std::to_string(columns) + " columns, found " + std::to_string(row.size()));
+	}
+
+	for (size_t j = 0; j < row.size(); ++j) {
+		block[j * block_rows + block_count] = row[j];
+	}
+	block_labels[block_count] = label;
+	block_count++;
+	total_rows++;
+
+	if (block_count == block_rows) {
+		write_block();
+		block_count = 0;
+		std::fill(block.begin(), block.end(), 0.0);
+		std::fill(block_labels.begin(), block_labels.end(), 0);
+		if (!file) {
+			throw std::runtime_error("error while writing file " + path);
+		}
+	}
+}
+
+void dataset_writer::flush()
+{
+	if (closed) return;
+
+	if (block_count > 0) {
+		write_block();
+	}
+	write_header();
+	file.flush();
+
+	if (!file) {
+		throw std::runtime_error("error while writing file " + path);
+	}
+}
+
+void dataset_writer::close()
+{
+	if (closed) return;
+
+	flush();
+	closed = true;
+	file.close();
+}
+
+void dataset_writer::write_header()
+{
+	dataset_header header;
+	std::memcpy(header.magic, dataset_header::magic_value, sizeof(header.magic));
+	header.version = dataset_header::current_version;
+	header.feature_type = dataset_header::type_float64;
+	header.label_type = dataset_header::type_uint64;
+	header.rows = total_rows;
+	header.cols = columns;
+	header.block_rows = block_rows;
+	header = convert(header);
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void dataset_writer::write_block()
+{
+	//the open block is the last one, rows of the full blocks precede it
+	const uint64_t index = (total_rows - block_count) / block_rows;
+	file.seekp(sizeof(dataset_header) + index * block_rows * (columns + 1) * sizeof(double));
+	write_values(file, block.data(), block.size());
+	write_values(file, block_labels.data(), block_labels.size());
+}
+
+dataset_view::dataset_view(const std::string& path) : file(path)
+{
+	if (file.size() < sizeof(dataset_header)) {
+		throw std::invalid_argument("invalid dataset " + path);
+	}
+
+	std::memcpy(&header, file.data(), sizeof(header));
+	header = convert(header);
+	if (!supported(header)) {
+		throw std::invalid_argument("unsupported dataset " + path);
+	}
+
+	uint64_t expected = 0;
+	if (!dataset_size(header, file.size(), expected) || file.size() < expected) {
+		throw std::invalid_argument("truncated dataset " + path);
+	}
+
+	if (little_endian()) {
+		features = reinterpret_cast<const double*>(file.data() + sizeof(dataset_header));
+	}
+	else {
+		swapped.resize(static_cast<size_t>((expected - sizeof(dataset_header)) / sizeof(uint64_t)));
+		std::memcpy(swapped.data(), file.data() + sizeof(dataset_header), swapped.size() * sizeof(uint64_t));
+		for (auto& value : swapped) value = swap_bytes(value);
+		features = reinterpret_cast<const double*>(swapped.data());
+	}
+}
+
+bool dataset_view::is_dataset(const std::string& path)
+{
+	char magic[4] = {};
+	std::ifstream f(path, std::ios::binary);
+	f.read(magic, sizeof(magic));
+	return f && std::memcmp(magic, dataset_header::magic_value, sizeof(magic)) == 0;
+}
+
+std::vector<std::vector<double>> dataset_view::to_rows() const
+{
+	std::vector<std::vector<double>> mat(rows(), std::vector<double>(cols()));
+	for (size_t b = 0; b < blocks(); ++b) {
+		const size_t first = b * block_rows();
+		for (size_t j = 0; j < cols(); ++j) {
+			const double* c = column(b, j);
+			for (size_t i = 0; i < block_size(b); ++i) {
+				mat[first + i][j] = c[i];
+			}
+		}
+	}
+	return mat;
+}
+
+std::vector<unsigned long> dataset_view::to_labels() const
+{
+	std::vector<unsigned long> result;
+	result.reserve(rows());
+	for (size_t b = 0; b < blocks(); ++b) {
+		result.insert(result.end(), labels(b), labels(b) + block_size(b));
+	}
+	return result;
+}
@@ -0,0 +1,118 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+/**
+* Binary columnar dataset format.
+* Little-endian header followed by blocks of block_rows rows. A block holds the feature columns (each block_rows * float64)
+* and the labels (block_rows * uint64), the last block is padded to the full size. Blocks let the writer stream rows
+* with bounded memory and append to an existing dataset, while the reader keeps zero-copy access to the columns of a block.
+* All values are written little-endian regardless of the host.
+*/
+struct dataset_header
+{
+	static constexpr char magic_value[4] = { 'S', 'C', 'D', 'S' };
+	static constexpr uint32_t current_version = 2;
+	static constexpr uint32_t type_float64 = 1;
+	static constexpr uint32_t type_uint64 = 2;
+
+	char magic[4];
+	uint32_t version;
+	uint32_t feature_type;
+	uint32_t label_type;
+	uint64_t rows;
+	uint64_t cols;
+	uint64_t block_rows;
+};
+
+/**
+* Streaming writer of the binary dataset, only the open (last) block is kept in memory.
+* Full blocks are written immediately, flush() writes the open block and the row count, so the file is a valid dataset after each flush.
+*/
+class dataset_writer
+{
+public:
+	static constexpr size_t default_block_rows = 1024;
+
+	/*Creates the dataset, or appends rows to the existing dataset if append is set (the column count must match)
+	 * Throws std::runtime_error if the file cannot be written and std::invalid_argument if the existing dataset differs.
+	 */
+	dataset_writer(const std::string& path, size_t cols, bool append = false, size_t block_rows = default_block_rows);
+	~dataset_writer();
+
+	dataset_writer(const dataset_writer&) = delete;
+	dataset_writer& operator=(const dataset_writer&) = delete;
+
+	/*Append row, throws std::invalid_argument if the row size differs from column count*/
+	void push_back(const std::vector<double>& row, uint64_t label);
+	/*Write the open block and the row count, throws std::runtime_error if the file cannot be written*/
+	void flush();
+	/*Flush and close the file*/
+	void close();
+
+	size_t rows() const { return static_cast<size_t>(total_rows); }
+	size_t cols() const { return columns; }
+
+private:
+	std::string path;
+	std::fstream file;
+	size_t columns;
+	size_t block_rows;
+	uint64_t total_rows = 0;
+
+	//open block with the column stride block_rows
+	std::vector<double> block;
+	std::vector<uint64_t> block_labels;
+	size_t block_count = 0;
+	bool closed = false;
+
+	void write_header();
+	void write_block();
+};
+
+/**
+* Zero-copy reader of the memory mapped binary dataset (the file is copied only on big-endian hosts).
+*/
+class dataset_view
+{
+public:
+	/*Maps dataset, throws std::invalid_argument if the file is not valid dataset*/
+	explicit dataset_view(const std::string& path);
+
+	/*Checks the magic value of the file*/
+	static bool is_dataset(const std::string& path);
+
+	size_t rows() const { return static_cast<size_t>(header.rows); }
+	size_t cols() const { return static_cast<size_t>(header.cols); }
+
+	size_t blocks() const { return (rows() + block_rows() - 1) / block_rows(); }
+	size_t block_rows() const { return static_cast<size_t>(header.block_rows); }
+	/*Number of rows of the block, all blocks except the last one are full*/
+	size_t block_size(size_t b) const { return b + 1 < blocks() ? block_rows() : rows() - b * block_rows(); }
+
+	const double* column(size_t b, size_t j) const { return features + b * block_rows() * (cols() + 1) + j * block_rows(); }
+	const uint64_t* labels(size_t b) const { return reinterpret_cast<const uint64_t*>(column(b, cols())); }
+
+	double value(size_t i, size_t j) const { return column(i / block_rows(), j)[i % block_rows()]; }
+	uint64_t label(size_t i) const { return labels(i / block_rows())[i % block_rows()]; }
+
+	/*Copy to the row layout used by sklearn-style trainers*/
+	std::vector<std::vector<double>> to_rows() const;
+	std::vector<unsigned long> to_labels() const;
+
+private:
+	mapped_file file;
+	dataset_header header;
+	//payload converted to the host byte order on big-endian hosts
+	std::vector<uint64_t> swapped;
+	const double* features = nullptr;
+};
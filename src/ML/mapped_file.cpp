@@ -0,0 +1,90 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::string& path)
+{
+	_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_file == INVALID_HANDLE_VALUE) {
+		_file = nullptr;
+		throw std::invalid_argument("error while opening file " + path);
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_file, &size)) {
+		CloseHandle(_file);
+		throw std::invalid_argument("error while reading size of file " + path);
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+	if (_size == 0) return; //empty file cannot be mapped
+
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping) {
+		_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!_data) {
+		if (_mapping) CloseHandle(_mapping);
+		CloseHandle(_file);
+		throw std::invalid_argument("error while mapping file " + path);
+	}
+}
+
+mapped_file::~mapped_file()
+{
+	if (_data) UnmapViewOfFile(_data);
+	if (_mapping) CloseHandle(_mapping);
+	if (_file) CloseHandle(_file);
+}
+
+#else
+
+mapped_file::mapped_file(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::invalid_argument("error while opening file " + path);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::invalid_argument("error while reading size of file " + path);
+	}
+	_size = static_cast<size_t>(st.st_size);
+	if (_size == 0) { //empty file cannot be mapped
+		close(fd);
+		return;
+	}
+
+	void* ptr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //mapping keeps the file referenced
+	if (ptr == MAP_FAILED) {
+		throw std::invalid_argument("error while mapping file " + path);
+	}
+	madvise(ptr, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const char*>(ptr);
+}
+
+mapped_file::~mapped_file()
+{
+	if (_data) munmap(const_cast<char*>(_data), _size);
+}
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+* Read-only memory mapped file
+*/
+class mapped_file
+{
+public:
+	/*Maps the whole file to memory, throws std::invalid_argument if the file cannot be mapped*/
+	explicit mapped_file(const std::string& path);
+	~mapped_file();
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	const char* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	const char* _data = nullptr;
+	size_t _size = 0;
+
+#ifdef _WIN32
+	void* _file = nullptr;
+	void* _mapping = nullptr;
+#endif
+};
@@ -4,26 +4,37 @@
 
 #undef Classify
 #include "ml.h"
+#include "csv_reader.h"
+#include "dataset.h"
+#include "sklearn/hash.h"
+#include "../snapshot.h"
+
+#include <random>
 
 ml::ml(char type, int n_signals, std::string path)
 {
     this->type = type;
 
+    //skip training if the model was already trained with the same data
+    const auto cache = cache_path(type, path);
+    if (std::filesystem::exists(cache)) {
+        load_model(cache.string());
+        return;
+    }
+
     switch (type) {
     case 'l':
     {
-        std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> data = ml::read_csv(path);
+        std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> data = ml::read_data(path);
         lg = std::make_unique <logistic_regression>(data.first, data.second, NODEBUG);
         lg->fit();
-        lg->save_model("model.json");
         break;
     }
     case 'b':
     {
-        std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> data = ml::read_csv(path);
+        std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> data = ml::read_data(path);
         nb = std::make_unique <gaussian_naive_bayes>(data.first, data.second, NODEBUG);
         nb->fit();
-        nb->save_model("model.json");
         break;
     }
     case 'd':
@@ -48,6 +59,39 @@ ml::ml(char type, int n_signals, std::string path)
        m_nb = std::make_unique<mlpack::naive_bayes::NaiveBayesClassifier<>>(data.first, data.second, 2);*/
        break;
     } }
+
+    //write to the temporary file first, so other processes never load partially written model
+    std::error_code ec;
+    std::filesystem::create_directories(cache.parent_path(), ec);
+    if (!ec) {
+        auto tmp = cache;
+        tmp += "." + std::to_string(std::random_device{}()) + ".tmp";
+        save_model(tmp.string());
+        std::filesystem::rename(tmp, cache, ec);
+    }
+}
+
+ml::ml(char type, const std::filesystem::path& model_path)
+{
+    this->type = type;
+    load_model(model_path.string());
+}
+
+ml::ml(char type)
+{
+    this->type = type;
+
+    if (type == 'b') {
+        nb = std::make_unique <gaussian_naive_bayes>(NODEBUG);
+    }
+}
+
+ml::ml(const ml& other)
+{
+    type = other.type;
+
+    if (other.lg) lg = std::make_unique<logistic_regression>(*other.lg);
+    if (other.nb) nb = std::make_unique<gaussian_naive_bayes>(*other.nb);
 }
 
 int ml::classify(std::vector<double> vec)
@@ -77,40 +121,137 @@ int ml::classify(std::vector<double> vec)
         break;
     } }
 
+    return res;
+}
+
+size_t ml::feature_count() const
+{
+    if (lg) return lg->feature_count();
+    if (nb) return nb->feature_count();
     return 0;
 }
 
-std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> ml::read_csv(std::string path) {
-    std::string line;
-    std::vector<std::vector<double>> mat;
-    std::vector<unsigned long> label;
+bool ml::can_partial_fit() const
+{
+    return type == 'b' && nb && nb->has_counts();
+}
 
-    std::ifstream f(path);
+bool ml::partial_fit(const std::vector<double>& vec, unsigned long label)
+{
+    switch (type) {
+    case 'b':
+        nb->partial_fit(vec, label);
+        return true;
+    default:
+        return false;
+    }
+}
 
+void ml::load_model(const std::string& model_path)
+{
+    switch (type) {
+    case 'l':
+        lg = std::make_unique<logistic_regression>(model_path);
+        break;
+    case 'b':
+        nb = std::make_unique<gaussian_naive_bayes>(NODEBUG);
+        nb->load_model(model_path);
+        break;
+    }
+}
+
+void ml::save_state(detection::CState_Snapshot& state) const
+{
+    state.write(nb ? nb->to_binary().data() : std::vector<char>());
+}
+
+bool ml::load_state(detection::CState_Snapshot& state)
+{
+    std::vector<char> payload;
+    state.read(payload);
+    if (!state.good() || type != 'b' || payload.empty()) return false;
+
+    binary_model model(binary_model::kind::gaussian_naive_bayes, std::move(payload));
     try {
-        if (!f.is_open()) {
-            throw (path);
-        };
+        auto restored = std::make_unique<gaussian_naive_bayes>(NODEBUG);
+        restored->load_binary(model);
+        nb = std::move(restored);
     }
-    catch (char* path) {
-        throw std::invalid_argument(("error while opening file " + std::string(path)).c_str());
+    catch (const char*) {
+        return false;
     }
+    return true;
+}
 
-    while (getline(f, line)) {
-        std::string val;
-        std::vector<double> row;
-        std::stringstream s(line);
+void ml::save_model(const std::string& model_path)
+{
+    switch (type) {
+    case 'l':
+        lg->save_model(model_path);
+        break;
+    case 'b':
+        nb->save_model(model_path);
+        break;
+    }
+}
 
-        getline(s, val, ','); //first column is label
-        label.push_back(stoul(val));
+char ml::model_type(const std::filesystem::path& model_path)
+{
+    binary_model::kind kind;
+    if (!binary_model::kind_of(model_path.string(), kind)) return 0;
 
-        while (getline(s, val, ','))
-            row.push_back(stod(val));
-        mat.push_back(row);
+    switch (kind) {
+    case binary_model::kind::logistic_regression:
+        return 'l';
+    case binary_model::kind::gaussian_naive_bayes:
+        return 'b';
+    default:
+        return 0;
+    }
+}
+
+std::string ml::file_hash(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) {
+        throw std::invalid_argument("error while opening file " + path);
+    }
+
+    meta::util::murmur_hash<8> hash(0);
+    std::vector<char> buffer(1 << 16);
+    while (f.read(buffer.data(), buffer.size()) || f.gcount() > 0) {
+        hash(buffer.data(), static_cast<std::size_t>(f.gcount()));
+    }
+
+    std::stringstream s;
+    s << std::hex << std::setw(16) << std::setfill('0') << static_cast<std::size_t>(hash);
+    return s.str();
+}
+
+std::filesystem::path ml::cache_path(char type, const std::string& path)
+{
+    return std::filesystem::temp_directory_path() / "detection_models" / (std::string(1, type) + "-" + file_hash(path) + ".model");
+}
+
+std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> ml::read_data(std::string path) {
+    if (dataset_view::is_dataset(path)) {
+        dataset_view data(path);
+        return std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>>(data.to_rows(), data.to_labels());
+    }
+
+    return read_csv(path);
+}
+
+std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> ml::read_csv(std::string path) {
+    csv_data data = csv_reader::read(path);
+
+    std::vector<std::vector<double>> mat;
+    mat.reserve(data.rows());
+    for (size_t i = 0; i < data.rows(); ++i) {
+        mat.emplace_back(data.row(i), data.row(i) + data.cols);
     }
-    f.close();
 
-    return std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>>(mat, label);
+    return std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>>(std::move(mat), std::move(data.labels));
 }
 
 /*
@@ -7,9 +7,15 @@
 //#include <mlpack/core.hpp>
 //#include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
 
+#include <filesystem>
+
 #include "sklearn/naive_bayes.h"
 #include "sklearn/logistic_regression.h"
 
+namespace detection {
+	class CState_Snapshot;
+}
+
 //#include <Eigen/Core>
 //#include <ldaplusplus/LDA.hpp>
 //#include <ldaplusplus/LDABuilder.hpp>
@@ -20,10 +26,27 @@
 class ml
 {
 public:
-	/*Creates classifier and train it.*/
+	/*Creates classifier and train it.
+	 * Trained model is cached by the hash of the training data, repeated training with the same data loads the cached model.
+	 */
 	ml(char type, int n_signals, std::string path);
+	/*Creates classifier from the trained model file.*/
+	ml(char type, const std::filesystem::path& model_path);
+	/*Creates untrained classifier for online learning.*/
+	explicit ml(char type);
+	/*Creates copy of the trained classifier.*/
+	ml(const ml& other);
+
+	/*Hash of the file content*/
+	static std::string file_hash(const std::string& path);
+	/*Type of the classifier stored in the binary model file, 0 if unknown (json or not a model)*/
+	static char model_type(const std::filesystem::path& model_path);
+	/*Path of the cached model trained from the given data*/
+	static std::filesystem::path cache_path(char type, const std::string& path);
 
-	/*Load csv*/
+	/*Load binary dataset or csv*/
+	static std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> read_data(std::string path);
+	/*Load csv, see csv_reader for contiguous data*/
 	static std::pair<std::vector<std::vector<double>>, std::vector<unsigned long>> read_csv(std::string path);
 	/* Load csv file to arma matrix.
 	 * Returns transposed matrix of data and row of labels.
@@ -34,9 +57,27 @@ public:
 	/*Classify data*/
 	int  classify(std::vector<double> vec);
 
+	/*Number of features expected by the trained classifier, 0 if not trained*/
+	size_t feature_count() const;
+
+	/*Classifier can be updated by partial_fit (naive Bayes with known sample counts)*/
+	bool can_partial_fit() const;
+	/*Update classifier with labelled data, returns false if not supported by the classifier*/
+	bool partial_fit(const std::vector<double>& vec, unsigned long label);
+
+	/*Write the model adapted by online learning to the filter state snapshot (naive Bayes only)*/
+	void save_state(detection::CState_Snapshot& state) const;
+	/*Replace the model by the one from the snapshot, returns false if the snapshot does not hold a valid model*/
+	bool load_state(detection::CState_Snapshot& state);
+
 private:
 	char type;
 
+	/*Load trained model*/
+	void load_model(const std::string& model_path);
+	/*Save trained model*/
+	void save_model(const std::string& model_path);
+
 	std::unique_ptr <logistic_regression> lg;
 	std::unique_ptr <gaussian_naive_bayes> nb;
 	//ldaplusplus::LDA<double>* lda;
@@ -3,6 +3,7 @@
  */
 
 #include "rnn.h"
+#include "../trace.h"
 
 std::unique_ptr<fdeep::model> rnn::model;
 
@@ -26,19 +27,25 @@ void rnn::load_model(const filesystem::path& path)
 
 float rnn::predict(scgms::UDevice_Event& event)
 {
+	return predict(event.segment_id(), event.device_time(), event.level());
+}
+
+float rnn::predict(uint64_t segment_id, double device_time, double level)
+{
+	detection::trace::CSpan span("rnn::predict", segment_id, device_time);
+
 	c++;
-	data.push_back(static_cast<float>(event.level()));
+	data.push_back(static_cast<float>(level));
 	if (data.size() > 1) {
-		const float d = static_cast<float>(event.level() - *(data.end() - headers) / 5);
+		const float d = static_cast<float>(level - *(data.end() - headers) / 5);
 		data.push_back(d);
 	}
 	else {
 		data.push_back(0.0f);
 	}
 
-	float device_time = (float)event.device_time();
 	float date;
-	float time = std::modf(device_time, &date);
+	float time = std::modf((float)device_time, &date);
 	float minute = time / (float)scgms::One_Minute;
 	minute = minute / 1440; //normalized
 	float hour;
@@ -53,3 +60,15 @@ float rnn::predict(scgms::UDevice_Event& event)
 
 	return 0;
 }
+
+void rnn::save_state(detection::CState_Snapshot& state) const
+{
+	state.write(static_cast<uint64_t>(c));
+	state.write(data);
+}
+
+void rnn::load_state(detection::CState_Snapshot& state)
+{
+	c = static_cast<int>(state.read_uint());
+	state.read(data);
+}
@@ -11,6 +11,7 @@
 #include <rtl/DeviceLib.h>
 #include <rtl/FilterLib.h>
 #include "../swl.h"
+#include "../snapshot.h"
 
 #include <string>
 
@@ -23,6 +24,11 @@ public:
 	static void load_model(const std::string &path);
 	static void load_model(const filesystem::path& path);
 	float predict(scgms::UDevice_Event& event);
+	float predict(uint64_t segment_id, double device_time, double level);
+
+	/*Input window of the segment*/
+	void save_state(detection::CState_Snapshot& state) const;
+	void load_state(detection::CState_Snapshot& state);
 
 private:
 	static std::unique_ptr<fdeep::model> model;
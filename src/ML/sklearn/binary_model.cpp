@@ -0,0 +1,185 @@
+// SWAMI KARUPPASWAMI THUNNAI
+
+#include <cstring>
+#include <fstream>
+#include "binary_model.h"
+#include "hash.h"
+
+namespace
+{
+	const char magic[4] = { 'S', 'C', 'M', 'D' };
+
+	struct header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t kind;
+		uint32_t reserved;
+		uint64_t size;
+		uint64_t checksum;
+	};
+
+	static_assert(sizeof(header) == 32, "model header must be packed");
+
+	bool little_endian()
+	{
+		const uint16_t one = 1;
+		unsigned char first = 0;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	uint32_t swap_bytes(uint32_t value)
+	{
+		return ((value & 0xFFu) << 24) | ((value & 0xFF00u) << 8) | ((value >> 8) & 0xFF00u) | (value >> 24);
+	}
+
+	uint64_t swap_bytes(uint64_t value)
+	{
+		return (static_cast<uint64_t>(swap_bytes(static_cast<uint32_t>(value))) << 32) | swap_bytes(static_cast<uint32_t>(value >> 32));
+	}
+
+	// Converts the header between the host and the file byte order (the conversion is symmetric)
+	header convert(header h)
+	{
+		if (!little_endian())
+		{
+			h.version = swap_bytes(h.version);
+			h.kind = swap_bytes(h.kind);
+			h.reserved = swap_bytes(h.reserved);
+			h.size = swap_bytes(h.size);
+			h.checksum = swap_bytes(h.checksum);
+		}
+		return h;
+	}
+
+	// Converts 8-byte value between the host and the little-endian payload
+	uint64_t convert(uint64_t value)
+	{
+		return little_endian() ? value : swap_bytes(value);
+	}
+}
+
+bool binary_model::is_binary(std::string model_name)
+{
+	char m[4] = {};
+	std::ifstream file(model_name, std::ios::binary);
+	file.read(m, sizeof(m));
+	return file && std::memcmp(m, magic, sizeof(m)) == 0;
+}
+
+bool binary_model::kind_of(std::string model_name, kind& type)
+{
+	header h;
+	std::ifstream file(model_name, std::ios::binary);
+	file.read(reinterpret_cast<char*>(&h), sizeof(h));
+	if (!file || std::memcmp(h.magic, magic, sizeof(magic)) != 0) return false;
+
+	h = convert(h);
+	type = static_cast<kind>(h.kind);
+	return true;
+}
+
+binary_model binary_model::load(std::string model_name, kind type)
+{
+	std::ifstream file(model_name, std::ios::binary);
+	if (!file.is_open()) throw "Model cannot be loaded because it cannot be opened!";
+
+	header h;
+	file.read(reinterpret_cast<char*>(&h), sizeof(h));
+	if (!file || std::memcmp(h.magic, magic, sizeof(magic)) != 0) throw "Model cannot be loaded because it is not binary model!";
+	h = convert(h);
+	if (h.version != version) throw "Model cannot be loaded because of unsupported version!";
+	if (h.kind != static_cast<uint32_t>(type)) throw "Model cannot be loaded because it is model of different type!";
+
+	// payload size must fit the file, so a corrupted header does not allocate or read past the end
+	const std::streamoff payload_begin = file.tellg();
+	file.seekg(0, std::ios::end);
+	const std::streamoff file_size = file.tellg();
+	file.seekg(payload_begin);
+	if (!file || file_size < payload_begin || h.size != static_cast<uint64_t>(file_size - payload_begin)) throw "Model cannot be loaded because it is truncated!";
+
+	binary_model model(type);
+	model.payload.resize(static_cast<size_t>(h.size));
+	file.read(model.payload.data(), model.payload.size());
+	if (!file || checksum(model.payload) != h.checksum) throw "Model cannot be loaded because it is corrupted!";
+
+	return model;
+}
+
+void binary_model::save(std::string model_name) const
+{
+	header h;
+	std::memcpy(h.magic, magic, sizeof(magic));
+	h.version = version;
+	h.kind = static_cast<uint32_t>(type);
+	h.reserved = 0;
+	h.size = payload.size();
+	h.checksum = checksum(payload);
+	h = convert(h);
+
+	std::ofstream file(model_name, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) throw "File cannot be opened for saving the model. May be the file is opened in some other place or you might not have proper permissions.";
+	file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	file.write(payload.data(), payload.size());
+	if (!file) throw "Model cannot be saved!";
+}
+
+void binary_model::write(uint64_t value)
+{
+	value = convert(value);
+	const char* p = reinterpret_cast<const char*>(&value);
+	payload.insert(payload.end(), p, p + sizeof(value));
+}
+
+void binary_model::write(const std::vector<double>& values)
+{
+	if (!little_endian())
+	{
+		for (double value : values)
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			write(bits);
+		}
+		return;
+	}
+
+	const char* p = reinterpret_cast<const char*>(values.data());
+	payload.insert(payload.end(), p, p + values.size() * sizeof(double));
+}
+
+uint64_t binary_model::read_uint()
+{
+	uint64_t value;
+	if (payload.size() - position < sizeof(value)) throw "Model cannot be loaded because it is truncated!";
+	std::memcpy(&value, payload.data() + position, sizeof(value));
+	position += sizeof(value);
+	return convert(value);
+}
+
+std::vector<double> binary_model::read_doubles(uint64_t count)
+{
+	if ((payload.size() - position) / sizeof(double) < count) throw "Model cannot be loaded because it is truncated!";
+	std::vector<double> values(static_cast<size_t>(count));
+	std::memcpy(values.data(), payload.data() + position, values.size() * sizeof(double));
+	position += values.size() * sizeof(double);
+	if (!little_endian())
+	{
+		for (double& value : values)
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			bits = swap_bytes(bits);
+			std::memcpy(&value, &bits, sizeof(bits));
+		}
+	}
+	return values;
+}
+
+uint64_t binary_model::checksum(const std::vector<char>& data)
+{
+	meta::util::murmur_hash<8> hash(0);
+	hash(data.data(), data.size());
+	return static_cast<uint64_t>(static_cast<std::size_t>(hash));
+}
@@ -0,0 +1,76 @@
+// SWAMI KARUPPASWAMI THUNNAI
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+Versioned binary model format shared by the sklearn-style models.
+Little-endian header with model kind, payload size and checksum followed by the payload
+of uint64 counts/labels and contiguous double arrays in the order used for prediction.
+All values are stored little-endian regardless of the host (converted on big-endian hosts).
+The payload is read to memory and copied to the structures of the model (it is not mapped),
+the payload size must match the size of the file.
+*/
+class binary_model
+{
+public:
+	enum class kind : uint32_t
+	{
+		linear_regression = 1,
+		logistic_regression = 2,
+		gaussian_naive_bayes = 3
+	};
+
+	static constexpr uint32_t version = 1;
+
+	/*
+	Creates empty model payload for saving
+	*/
+	explicit binary_model(kind type) : type(type) {}
+
+	/*
+	Creates model from the payload stored elsewhere (e.g. in the filter state snapshot)
+	*/
+	binary_model(kind type, std::vector<char> payload) : type(type), payload(std::move(payload)) {}
+
+	/*
+	Check whether the file is binary model (json otherwise)
+	*/
+	static bool is_binary(std::string model_name);
+
+	/*
+	Kind of the binary model stored in the file, false if the file is not binary model
+	*/
+	static bool kind_of(std::string model_name, kind& type);
+
+	/*
+	Load and validate the model, throws if the file is not valid model of the given kind
+	*/
+	static binary_model load(std::string model_name, kind type);
+
+	/*
+	Save the model with header and checksum
+	*/
+	void save(std::string model_name) const;
+
+	/*
+	Payload without the header
+	*/
+	const std::vector<char>& data() const { return payload; }
+
+	void write(uint64_t value);
+	void write(const std::vector<double>& values);
+
+	uint64_t read_uint();
+	std::vector<double> read_doubles(uint64_t count);
+
+private:
+	kind type;
+	std::vector<char> payload;
+	size_t position = 0;
+
+	static uint64_t checksum(const std::vector<char>& data);
+};
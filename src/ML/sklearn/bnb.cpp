@@ -2,6 +2,7 @@
 
 #include "bnb.h"
 #include <sstream>
+#include <algorithm>
 //#include <bits/stdc++.h>
 
 void bnb::print(std::string message)
@@ -3,6 +3,7 @@
 #include <iomanip>
 #include "logistic_regression.h"
 #include "json.h"
+#include "binary_model.h"
 
 using json = nlohmann::json;
 
@@ -18,6 +19,21 @@ void logistic_regression::get_unique_labels()
 
 logistic_regression::logistic_regression(std::string model_name)
 {
+	if (binary_model::is_binary(model_name))
+	{
+		// labels followed by the coefficient matrix, one row per label
+		binary_model model = binary_model::load(model_name, binary_model::kind::logistic_regression);
+		uint64_t label_count = model.read_uint();
+		uint64_t coef_count = model.read_uint();
+		std::vector<unsigned long int> labels;
+		for (uint64_t i = 0; i < label_count; i++) labels.push_back(static_cast<unsigned long int>(model.read_uint()));
+		for (unsigned long int label : labels)
+		{
+			unique_lables.insert(label);
+			bias_map[label] = model.read_doubles(coef_count);
+		}
+		return;
+	}
 	std::ifstream file;
 	file.open(model_name);
 	if (!file.is_open()) throw "Model cannot be loaded because it cannot be opened!";
@@ -80,6 +96,16 @@ std::map<unsigned long int, double> logistic_regression::predict(std::vector<dou
 }
 
 void logistic_regression::save_model(std::string model_name)
+{
+	binary_model model(binary_model::kind::logistic_regression);
+	model.write(bias_map.size());
+	model.write(bias_map.empty() ? 0 : bias_map.begin()->second.size());
+	for (const auto& b : bias_map) model.write(b.first);
+	for (const auto& b : bias_map) model.write(b.second);
+	model.save(model_name);
+}
+
+void logistic_regression::export_json(std::string model_name)
 {
 	json j;
 	std::map<unsigned long int, std::vector<double>>::iterator itr1 = bias_map.begin();
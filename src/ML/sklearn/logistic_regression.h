@@ -25,6 +25,9 @@ public:
 	logistic_regression(std::string model_name);
 	void fit();
 	std::map<unsigned long int, double> predict(std::vector<double> test);
+	// Number of features of the trained model (without the bias), 0 if not trained
+	size_t feature_count() const { return bias_map.empty() ? 0 : bias_map.begin()->second.size() - 1; }
 	void save_model(std::string model_name);
+	void export_json(std::string model_name);
 };
 
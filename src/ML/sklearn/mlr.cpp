@@ -5,6 +5,7 @@
 #include "mlr.h"
 #include "matrix.h"
 #include "json.h"
+#include "binary_model.h"
 
 using json = nlohmann::json;
 
@@ -16,6 +17,12 @@ void LinearRegression::print(std::string message)
 
 LinearRegression::LinearRegression(std::string model_name)
 {
+	if (binary_model::is_binary(model_name))
+	{
+		binary_model model = binary_model::load(model_name, binary_model::kind::linear_regression);
+		bias = model.read_doubles(model.read_uint());
+		return;
+	}
 	std::ifstream file;
 	file.open(model_name);
 	if (!file.is_open()) throw "Model cannot be loaded because it cannot be opened!";
@@ -97,6 +104,14 @@ double LinearRegression::predict(std::vector<double> test)
 }
 
 void LinearRegression::save_model(std::string model_name)
+{
+	binary_model model(binary_model::kind::linear_regression);
+	model.write(bias.size());
+	model.write(bias);
+	model.save(model_name);
+}
+
+void LinearRegression::export_json(std::string model_name)
 {
 	json j;
 	j["bias"] = bias;
@@ -30,6 +30,7 @@ public:
 	void fit();
 	double predict(std::vector<double> test);
 	void save_model(std::string model_name);
+	void export_json(std::string model_name);
 
 	std::vector<double> get_bias();
 };
\ No newline at end of file
@@ -27,7 +27,9 @@ void gaussian_naive_bayes::calculate_y_probabilities()
 	print("Calculating probabilities of labels");
 	for (unsigned long int i : unique_labels)
 	{
-		double p = std::count(y.begin(), y.end(), i) / double(toatal_labels);
+		unsigned long int count = std::count(y.begin(), y.end(), i);
+		label_count[i] = count;
+		double p = count / double(toatal_labels);
 		y_prob[i] = p;
 	}
 	print("Calculated probabilities of labels");
@@ -125,11 +127,60 @@ void gaussian_naive_bayes::fit()
 			}
 		}
 	}
+	// Training data are no longer needed, the model is updated by partial_fit
+	std::vector<std::vector<double>>().swap(X);
+	std::vector<unsigned long int>().swap(y);
+}
+
+void gaussian_naive_bayes::partial_fit(const std::vector<double>& X_sample, unsigned long int label)
+{
+	unsigned long int count = ++label_count[label];
+	labels.insert(label);
+
+	std::vector<mean_variance>& mv_vec = mean_variance_map[label];
+	if (mv_vec.empty())
+	{
+		for (unsigned long int column = 0; column < X_sample.size(); column++)
+		{
+			mv_vec.push_back(mean_variance(column, 0.0, 0.0));
+		}
+	}
+	else if (mv_vec.size() != X_sample.size())
+	{
+		throw "Sample size does not match the number of features of the model!";
+	}
+
+	for (unsigned long int column = 0; column < X_sample.size(); column++)
+	{
+		mv_vec[column].update(X_sample[column], count);
+	}
+
+	unsigned long int total = 0;
+	for (const auto& c : label_count) total += c.second;
+	for (const auto& c : label_count) y_prob[c.first] = c.second / double(total);
+}
+
+bool gaussian_naive_bayes::has_counts() const
+{
+	for (const auto& mv : mean_variance_map)
+	{
+		if (label_count.find(mv.first) == label_count.end()) return false;
+	}
+	return true;
 }
 
 std::map<unsigned long int, double> gaussian_naive_bayes::predict(std::vector<double> X_test)
 {
 	std::map<unsigned long int, double> probability;
+
+	// Variance floor, 1 if all variances are zero (labels with single samples only)
+	double max_variance = 0.0;
+	for (auto& mv : mean_variance_map)
+	{
+		for (mean_variance& i : mv.second) max_variance = std::max(max_variance, i.get_variance());
+	}
+	const double epsilon = var_smoothing * (max_variance > 0.0 ? max_variance : 1.0);
+
 	std::map<unsigned long int, std::vector<mean_variance>>::iterator itr1 = mean_variance_map.begin();
 	std::map<unsigned long int, std::vector<mean_variance>>::iterator itr2 = mean_variance_map.end();
 	for (std::map<unsigned long int, std::vector<mean_variance>>::iterator itr = itr1; itr != itr2; ++itr)
@@ -142,9 +193,10 @@ std::map<unsigned long int, double> gaussian_naive_bayes::predict(std::vector<do
 			double column_value = X_test[column];
 			// Calculate Gaussian Normal distribution
 			double mean = mv.get_mean();
-			double mean_square_by_two_sigma = std::pow((column_value - mean), 2) / (2 * mv.get_variance());
+			double variance = mv.get_variance() + epsilon;
+			double mean_square_by_two_sigma = std::pow((column_value - mean), 2) / (2 * variance);
 			double exp_neg_mean_square_by_sigma = std::exp(-1 * mean_square_by_two_sigma);
-			double gnb = (1 / (sqrt(2 * PI * mv.get_variance()))) * exp_neg_mean_square_by_sigma;
+			double gnb = (1 / (sqrt(2 * PI * variance))) * exp_neg_mean_square_by_sigma;
 			// std::cout << "COLUMN VALUE: " << column_value << " MEAN: " << mean << "  VARIANCE: " << mv.get_variance() << " GNB: " << gnb << "\n";
 			posterior_numerator.push_back(gnb);
 		}
@@ -159,9 +211,46 @@ std::map<unsigned long int, double> gaussian_naive_bayes::predict(std::vector<do
 }
 
 void gaussian_naive_bayes::save_model(std::string model_name)
+{
+	to_binary().save(model_name);
+}
+
+binary_model gaussian_naive_bayes::to_binary() const
+{
+	// labels, counts, then mean and variance matrices with one row per label
+	uint64_t feature_count = mean_variance_map.empty() ? 0 : mean_variance_map.begin()->second.size();
+	binary_model model(binary_model::kind::gaussian_naive_bayes);
+	model.write(mean_variance_map.size());
+	model.write(feature_count);
+	for (const auto& mv : mean_variance_map) model.write(mv.first);
+	for (const auto& mv : mean_variance_map)
+	{
+		auto count = label_count.find(mv.first);
+		model.write(count == label_count.end() ? 0 : count->second);
+	}
+	for (const auto& mv : mean_variance_map)
+	{
+		std::vector<double> means;
+		for (mean_variance i : mv.second) means.push_back(i.get_mean());
+		model.write(means);
+	}
+	for (const auto& mv : mean_variance_map)
+	{
+		std::vector<double> variances;
+		for (mean_variance i : mv.second) variances.push_back(i.get_variance());
+		model.write(variances);
+	}
+	return model;
+}
+
+void gaussian_naive_bayes::export_json(std::string model_name)
 {
 	json j;
 	j["labels"] = labels;
+	for (const auto& c : label_count)
+	{
+		j["count"][std::to_string(c.first)] = c.second;
+	}
 	std::map<unsigned long int, std::vector<mean_variance>>::iterator itr1 = mean_variance_map.begin();
 	std::map<unsigned long int, std::vector<mean_variance>>::iterator itr2 = mean_variance_map.end();
 	for (std::map<unsigned long int, std::vector<mean_variance>>::iterator itr = itr1; itr != itr2; ++itr)
@@ -189,6 +278,12 @@ void gaussian_naive_bayes::save_model(std::string model_name)
 
 void gaussian_naive_bayes::load_model(std::string model_name)
 {
+	if (binary_model::is_binary(model_name))
+	{
+		binary_model model = binary_model::load(model_name, binary_model::kind::gaussian_naive_bayes);
+		load_binary(model);
+		return;
+	}
 	std::ifstream file;
 	file.open(model_name);
 	if (!file.is_open()) throw "Model cannot be loaded because it cannot be opened!";
@@ -207,5 +302,35 @@ void gaussian_naive_bayes::load_model(std::string model_name)
 			mv_vector.push_back(mv);
 		}
 		mean_variance_map[label] = mv_vector;
+		labels.insert(label);
+		// models saved before partial_fit support do not store counts
+		if (j.contains("count")) label_count[label] = j["count"][label_name];
+	}
+}
+
+void gaussian_naive_bayes::load_binary(binary_model& model)
+{
+	uint64_t n_labels = model.read_uint();
+	uint64_t feature_count = model.read_uint();
+	std::vector<unsigned long int> label_vector;
+	for (uint64_t i = 0; i < n_labels; i++) label_vector.push_back(static_cast<unsigned long int>(model.read_uint()));
+	for (unsigned long int label : label_vector)
+	{
+		labels.insert(label);
+		uint64_t count = model.read_uint();
+		if (count > 0) label_count[label] = static_cast<unsigned long int>(count);
+	}
+	for (unsigned long int label : label_vector)
+	{
+		std::vector<double> means = model.read_doubles(feature_count);
+		std::vector<mean_variance> mv_vector;
+		for (unsigned long int column = 0; column < feature_count; column++) mv_vector.push_back(mean_variance(column, means[column], 0.0));
+		mean_variance_map[label] = mv_vector;
+	}
+	for (unsigned long int label : label_vector)
+	{
+		std::vector<double> variances = model.read_doubles(feature_count);
+		std::vector<mean_variance>& mv_vector = mean_variance_map[label];
+		for (unsigned long int column = 0; column < feature_count; column++) mv_vector[column] = mean_variance(column, mv_vector[column].get_mean(), variances[column]);
 	}
 }
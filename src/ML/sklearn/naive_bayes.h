@@ -4,6 +4,7 @@
 #define DEBUG 1
 #define NODEBUG 0
 #define PI 3.141592653589793238462643383279502884L
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -13,6 +14,7 @@
 #include <set>
 #include <map>
 #include "json.h"
+#include "binary_model.h"
 
 using json = nlohmann::json;
 
@@ -43,6 +45,17 @@ public:
 	{
 		return variance;
 	}
+
+	/*
+	Welford's online update with a new value, count is the number of values including the new one
+	*/
+	void update(double value, unsigned long int count)
+	{
+		double delta = value - _mean;
+		_mean += delta / double(count);
+		double m2 = (count > 2 ? variance * double(count - 2) : 0.0) + delta * (value - _mean);
+		variance = count > 1 ? m2 / double(count - 1) : 0.0;
+	}
 };
 
 /*
@@ -72,6 +85,13 @@ private:
 	// label, column, mean and variance
 	std::map<unsigned long int, std::vector<mean_variance>> mean_variance_map;
 
+	// Number of samples seen for each label (used by partial_fit)
+	std::map<unsigned long int, unsigned long int> label_count;
+
+	// Portion of the largest variance added to all variances in predict (scikit-learn's var_smoothing),
+	// a label with a single sample has zero variance
+	double var_smoothing = 1e-9;
+
 	
 
 private:
@@ -95,6 +115,22 @@ public:
 	*/
 	void fit();
 
+	/*
+	For updating the model with a single labelled sample without retraining
+	*/
+	void partial_fit(const std::vector<double>& X_sample, unsigned long int label);
+
+	/*
+	Model can be updated by partial_fit, i.e. sample counts are known for all trained labels
+	(json models saved before partial_fit support do not store them)
+	*/
+	bool has_counts() const;
+
+	/*
+	Number of features of the trained model, 0 if not trained
+	*/
+	size_t feature_count() const { return mean_variance_map.empty() ? 0 : mean_variance_map.begin()->second.size(); }
+
 	/*
 	For predicting output
 	*/
@@ -105,6 +141,21 @@ public:
 	*/
 	void save_model(std::string model_name);
 
+	/*
+	Binary payload of the model (see save_model)
+	*/
+	binary_model to_binary() const;
+
+	/*
+	Used to load the model from the binary payload
+	*/
+	void load_binary(binary_model& model);
+
+	/*
+	Used to export the model to json
+	*/
+	void export_json(std::string model_name);
+
 	/*
 	Used to load the saved model
 	*/
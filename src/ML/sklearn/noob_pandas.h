@@ -5,7 +5,9 @@
 #include <vector>
 #include <fstream>
 #include <typeinfo>
+#include <type_traits>
 #include "json.h"
+#include "../dataset.h"
 
 using json = nlohmann::json;
 
@@ -19,6 +21,28 @@ private:
 public:
 	noob_pandas(std::string data_set)
 	{
+		// Numeric binary datasets are mapped directly instead of parsing json
+		if constexpr (std::is_arithmetic<D>::value && std::is_arithmetic<T>::value)
+		{
+			if (dataset_view::is_dataset(data_set))
+			{
+				dataset_view data(data_set);
+				X.assign(data.rows(), std::vector<D>(data.cols()));
+				y.resize(data.rows());
+				for (unsigned long int block = 0; block < data.blocks(); block++)
+				{
+					const unsigned long int first = block * data.block_rows();
+					for (unsigned long int column = 0; column < data.cols(); column++)
+					{
+						const double* values = data.column(block, column);
+						for (unsigned long int i = 0; i < data.block_size(block); i++) X[first + i][column] = static_cast<D>(values[i]);
+					}
+					const uint64_t* labels = data.labels(block);
+					for (unsigned long int i = 0; i < data.block_size(block); i++) y[first + i] = static_cast<T>(labels[i]);
+				}
+				return;
+			}
+		}
 		std::ifstream file;
 		file.open(data_set);
 		if (!file.is_open()) throw "Dataset cannot be opened!";
@@ -0,0 +1,79 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "swl.h"
+
+/*Window of the last activations of one edge direction
+ * Position i is the age of a value (0 = newest). The window keeps the sum of the positions of the values
+ * that reach the threshold of their position (values[i] >= thresholds[i], thresholds are increasing with i)
+ * and the maximum of the newest values, so a sample costs O(log width) regardless of the window size.
+ * A value reaches the thresholds up to a position found once when it is pushed, its expiration is scheduled
+ * to a ring of buckets and the sum of positions is derived from the number and the sum of steps of the values.
+ */
+class activation_window
+{
+public:
+	activation_window() : activation_window(12, 6) {};
+	activation_window(size_t width, size_t max_width) : _values(width), _max_width(std::min(max_width, width)), _expiry(width + 1) {};
+
+	/*Sum of the positions of the values reaching their thresholds*/
+	uint64_t position_sum() const {
+		return _count > 0 ? _count * (_step - 1) - _steps : 0;
+	}
+
+	/*Maximum of the newest max_width values, the window must not be empty*/
+	double max() const { return _max.front().second; }
+
+	bool empty() const { return _values.empty(); }
+
+	/*Values from the oldest one*/
+	const swl<double>& values() const { return _values; }
+
+	void push(double value, const std::vector<double>& thresholds) {
+		_values.push_back(value);
+
+		while (!_max.empty() && _max.back().second <= value) _max.pop_back();
+		_max.emplace_back(_step, value);
+		while (_max.front().first + _max_width <= _step) _max.pop_front();
+
+		//the value reaches the thresholds of positions 0 .. reached - 1 (at most the width of the window)
+		const size_t reached = std::min(static_cast<size_t>(std::upper_bound(thresholds.begin(), thresholds.end(), value) - thresholds.begin()), _values._width);
+		if (reached > 0) {
+			//position of the value at step s is s - _step - 1, so it leaves at step _step + reached + 1
+			_count++;
+			_steps += _step;
+			auto& bucket = _expiry[(_step + reached + 1) % _expiry.size()];
+			bucket.first++;
+			bucket.second += _step;
+		}
+
+		_step++;
+
+		//values leaving their thresholds at the next step
+		auto& expired = _expiry[_step % _expiry.size()];
+		_count -= expired.first;
+		_steps -= expired.second;
+		expired = { 0, 0 };
+	}
+
+private:
+	swl<double> _values;
+	size_t _max_width;
+	//decreasing values of the newest max_width values with the step of the value
+	std::deque<std::pair<uint64_t, double>> _max;
+
+	uint64_t _step = 0;
+	//number and sum of steps of the values reaching their thresholds
+	uint64_t _count = 0;
+	uint64_t _steps = 0;
+	std::vector<std::pair<uint64_t, uint64_t>> _expiry;
+};
@@ -0,0 +1,183 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#include "async_filter.h"
+#include "descriptor.h"
+
+namespace {
+	//yields of the idle worker before it goes to sleep
+	constexpr size_t idle_spins = 64;
+}
+
+CAsync_Filter::CAsync_Filter(scgms::IFilter* output) : CBase_Filter(output) {
+	//
+}
+
+CAsync_Filter::~CAsync_Filter() {
+	stop_worker();
+}
+
+HRESULT IfaceCalling CAsync_Filter::QueryInterface(const GUID* riid, void** ppvObj) {
+	if (Internal_Query_Interface<scgms::IFilter>(detection::id_async, *riid, ppvObj)) return S_OK;
+
+	return E_NOINTERFACE;
+}
+
+HRESULT IfaceCalling CAsync_Filter::Do_Configure(scgms::SFilter_Configuration configuration, refcnt::Swstr_list& error_description) {
+	auto size = configuration.Read_Int(detection::rsQueueSize, 4096);
+	auto batch = configuration.Read_Int(detection::rsBatchSize, 64);
+
+	if (size < 1) {
+		error_description.push(L"Size of the queue must be at least 1!");
+		return E_INVALIDARG;
+	}
+	if (batch < 1) {
+		error_description.push(L"Size of the batch must be at least 1!");
+		return E_INVALIDARG;
+	}
+
+	stop_worker();
+
+	queue_size = static_cast<size_t>(size);
+	batch_size = static_cast<size_t>(batch);
+	queue = std::make_unique<spsc_queue<scgms::UDevice_Event>>(queue_size);
+	metrics.state(0, queue->capacity() * sizeof(scgms::UDevice_Event));
+
+	start_worker();
+
+	return S_OK;
+}
+
+HRESULT IfaceCalling CAsync_Filter::Do_Execute(scgms::UDevice_Event event) {
+	auto scope = metrics.measure(event);
+
+	//after Shut_Down (or without configuration) the events are passed synchronously
+	if (!worker.joinable()) {
+		return metrics.send(mOutput, event);
+	}
+
+	const bool shut_down = event.event_code() == scgms::NDevice_Event_Code::Shut_Down;
+
+	//backpressure, the event is moved only when there is a free slot
+	while (!queue->try_push(std::move(event))) {
+		std::this_thread::yield();
+	}
+	wake_worker();
+
+	if (shut_down) {
+		stop_worker();
+	}
+
+	return output_error.load(std::memory_order_relaxed);
+}
+
+void CAsync_Filter::run() {
+	size_t idle = 0;
+
+	while (true) {
+		const size_t count = queue->consume(batch_size, [this](scgms::UDevice_Event& event) {
+			auto rc = mOutput.Send(event);
+			if (!Succeeded(rc)) {
+				HRESULT expected = S_OK;
+				output_error.compare_exchange_strong(expected, rc, std::memory_order_relaxed);
+			}
+		});
+
+		if (count > 0) {
+			metrics.emitted(count);
+			idle = 0;
+			continue;
+		}
+
+		//stop is set after the last push, so the queue is drained when it is seen empty afterwards
+		if (stop.load(std::memory_order_acquire)) {
+			if (queue->empty()) break;
+			continue;
+		}
+
+		if (++idle < idle_spins) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleeping.store(true, std::memory_order_seq_cst);
+		wake_up.wait(lock, [this]() { return !queue->empty() || stop.load(std::memory_order_acquire); });
+		sleeping.store(false, std::memory_order_relaxed);
+		idle = 0;
+	}
+}
+
+void CAsync_Filter::start_worker() {
+	stop.store(false, std::memory_order_relaxed);
+	worker = std::thread(&CAsync_Filter::run, this);
+}
+
+void CAsync_Filter::stop_worker() {
+	if (!worker.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stop.store(true, std::memory_order_release);
+	}
+	wake_up.notify_one();
+	worker.join();
+}
+
+void CAsync_Filter::wake_worker() {
+	//pairs with the sequentially consistent push, either the worker sees the event or the producer sees it sleeping
+	if (sleeping.load(std::memory_order_seq_cst)) {
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		wake_up.notify_one();
+	}
+}
@@ -0,0 +1,115 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+#include <rtl/referencedImpl.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "descriptor.h"
+#include "spsc_queue.h"
+#include "metrics.h"
+
+
+
+#pragma warning( push )
+#pragma warning( disable : 4250 ) // C4250 - 'class1' : inherits 'class2::member' via dominance
+
+/*Asynchronous decoupling of two filters
+ * Execute only moves the event to a bounded lock-free queue, a worker thread sends the queued events
+ * to the output in batches, so the filters before and after the queue run on separate threads.
+ * The queue keeps the order of all events (and so the order within every segment). A full queue
+ * blocks the caller until the worker frees a slot (backpressure). Shut_Down is sent after all
+ * queued events and Execute returns when the worker has finished.
+ */
+class CAsync_Filter : public scgms::CBase_Filter {
+
+protected:
+	virtual HRESULT Do_Execute(scgms::UDevice_Event event) override final;
+	virtual HRESULT Do_Configure(scgms::SFilter_Configuration configuration, refcnt::Swstr_list& error_description) override final;
+public:
+	CAsync_Filter(scgms::IFilter* output);
+	virtual ~CAsync_Filter();
+
+	virtual HRESULT IfaceCalling QueryInterface(const GUID* riid, void** ppvObj) override final;
+
+private:
+	size_t queue_size = 4096;
+	size_t batch_size = 64;
+
+	std::unique_ptr<spsc_queue<scgms::UDevice_Event>> queue;
+	std::thread worker;
+
+	//the worker sleeps on the condition variable only when the queue stays empty
+	std::mutex sleep_mutex;
+	std::condition_variable wake_up;
+	std::atomic<bool> sleeping{ false };
+	std::atomic<bool> stop{ false };
+
+	//first failure of the output, returned by the following Execute calls
+	std::atomic<HRESULT> output_error{ S_OK };
+
+	detection::CFilter_Metrics metrics{ L"Asynchronous queue" };
+
+	void run();
+	void start_worker();
+	/*Sends the remaining events and joins the worker*/
+	void stop_worker();
+	void wake_worker();
+};
+
+#pragma warning( pop )
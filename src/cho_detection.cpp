@@ -51,6 +51,7 @@
   */
 
 #include "cho_detection.h"
+#include "trace.h"
 
 CCho_Detection::CCho_Detection(scgms::IFilter *output) : CBase_Filter(output) {
 	//
@@ -78,6 +79,7 @@ std::vector<double> split(const std::wstring& ws, wchar_t delim) {
 
 HRESULT IfaceCalling CCho_Detection::Do_Configure(scgms::SFilter_Configuration configuration, refcnt::Swstr_list& error_description) {
 	input_signal = configuration.Read_GUID(detection::rsSignal, detection::signal_savgol);
+	slope_signal = configuration.Read_GUID(detection::rsSlopeSignal, scgms::signal_Null);
 	window_size = configuration.Read_Int(detection::rsWindowSize, 12);
 	if(window_size < 1){
 		error_description.push(L"Window size must be at least 1!");
@@ -85,24 +87,43 @@ HRESULT IfaceCalling CCho_Detection::Do_Configure(scgms::SFilter_Configuration c
 	}
 
 	std::vector<double> lb, def, ub;
-	if (!configuration.Read_Parameters(detection::rsThresholds, lb, def, ub)) {
+	if (!configuration.Read_Parameters(detection::rsThresholds, lb, def, ub) || def.size() < 4) {
 		error_description.push(L"Cannot read the parameters!");
 		return E_INVALIDARG;
 	}
-
-	for (size_t i = 0; i < 2; i++) {
-		thresholds[i] = def[i * 2];
-		weights[i] = def[i * 2 + 1];
-	}
 	
-	th_act = configuration.Read_Double(detection::rsThAct, 2);
+	const double th_act = configuration.Read_Double(detection::rsThAct, 2);
 	if (th_act < 0) {
 		error_description.push(L"Activation threshold must be non-negative");
 		return E_INVALIDARG;
 	}
 	
 	detect_edges = configuration.Read_Bool(detection::rsEdges);
-	detect_desc = configuration.Read_Bool(detection::rsDesc);
+
+	ensemble.clear();
+	ensemble.add(def, th_act, configuration.Read_Bool(detection::rsDesc), window_size);
+
+	//further configurations "threshold low, weight low, threshold high, weight high, activation threshold, descending edges" separated by ';'
+	std::wstringstream ensemble_configurations(configuration.Read_String(detection::rsEnsemble));
+	std::wstring ensemble_configuration;
+	while (std::getline(ensemble_configurations, ensemble_configuration, L';')) {
+		if (ensemble_configuration.find_first_not_of(L" \t") == std::wstring::npos) continue;
+
+		std::vector<double> values;
+		try {
+			values = split(ensemble_configuration, L',');
+		}
+		catch (const std::exception&) {
+			values.clear();
+		}
+		if (values.size() != 6 || values[4] < 0 || ensemble.size() >= detection::max_ensemble) {
+			error_description.push(L"Cannot read the ensemble configurations!");
+			return E_INVALIDARG;
+		}
+		ensemble.add(values, values[4], values[5] != 0, window_size);
+	}
+	act.assign(ensemble.size(), 0.0);
+	act_m.assign(ensemble.size(), 0.0);
 	use_rnn = configuration.Read_Bool(detection::rsRnn);
 	
 	if(use_rnn)
@@ -120,148 +141,413 @@ HRESULT IfaceCalling CCho_Detection::Do_Configure(scgms::SFilter_Configuration c
 			return E_INVALIDARG;
 		}
 	}
+
+	smooth = configuration.Read_Bool(detection::rsSmooth);
+	if (smooth) {
+		savgol_window = configuration.Read_Int(detection::rsSavgolWindow, 21);
+		savgol_degree = configuration.Read_Int(detection::rsSavgolDeg, 3);
+		smooth_output = configuration.Read_Bool(detection::rsSmoothOutput);
+
+		if (savgol_degree < 1) {
+			error_description.push(L"Degree must be at least 1!");
+			return E_INVALIDARG;
+		}
+		if (savgol_window <= savgol_degree) {
+			error_description.push(L"Size of the window must be greater than degree!");
+			return E_INVALIDARG;
+		}
+		savgol.configure(savgol_window, savgol_degree);
+	}
+
+	const double heartbeat = configuration.Read_Int(detection::rsOutputHeartbeat, 0) * scgms::One_Minute;
+	if (!activation_output.configure(configuration.Read_String(detection::rsActivationOutput), heartbeat)
+		|| !detection_output.configure(configuration.Read_String(detection::rsDetectionOutput), heartbeat)) {
+		error_description.push(L"Output policy must be all, change or nonzero with non-negative heartbeat!");
+		return E_INVALIDARG;
+	}
+
+	auto ttl = configuration.Read_Int(detection::rsSegmentTTL, 0);
+	auto max_segments = configuration.Read_Int(detection::rsMaxSegments, 0);
+	if (ttl < 0 || max_segments < 0) {
+		error_description.push(L"Segment TTL and max segments must be non-negative!");
+		return E_INVALIDARG;
+	}
+	mSegments.set_limits(ttl * scgms::One_Minute, static_cast<size_t>(max_segments));
+	rnnSegments.set_limits(ttl * scgms::One_Minute, static_cast<size_t>(max_segments));
+
+	metrics.set_period(configuration.Read_Int(detection::rsMetricsPeriod, 0) * scgms::One_Minute);
+
+	auto snapshot_path = configuration.Read_File_Path(detection::rsSnapshotPath);
+	if (std::filesystem::is_directory(snapshot_path)) snapshot_path.clear();
+	snapshot.configure(snapshot_path, configuration.Read_Int(detection::rsSnapshotPeriod, 0) * scgms::One_Minute);
+	restore_state();
 	
 	return S_OK;
 }
 
 HRESULT IfaceCalling CCho_Detection::Do_Execute(scgms::UDevice_Event event) {
+	auto scope = metrics.measure(event);
+
+	if (mSegments.evict(event.device_time()) + rnnSegments.evict(event.device_time()) > 0) {
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+	}
+
+	if (metrics.report_due(event.device_time())) {
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+		auto report = metrics.report(detection::id_cho, event);
+		auto rc = metrics.send(mOutput, report);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	if (snapshot.due(event) && !save_state()) {
+		auto warning = detection::snapshot_warning(detection::id_cho, event);
+		auto rc = metrics.send(mOutput, warning);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
 
 	if (event.is_level_event() && event.signal_id() == input_signal) {
 		//get segment data
 		auto seg_id = event.segment_id();
-		auto it = mSegments.find(seg_id);
-		if (it == mSegments.end()) {
-			CHOSegmentData data = { false, -1, -1, swl<double>(window_size), swl<double>(window_size) };
-			it = mSegments.emplace(seg_id, data).first;
+		auto& data = mSegments.get(seg_id, event.device_time(), [this]() { return create_segment(); });
+
+		if (!smooth) {
+			auto rc = detect(seg_id, event.device_time(), event.level(), data);
+			if (!Succeeded(rc)) {
+				return rc;
+			}
 		}
+		else {
+			//fused smoothing, the same smoothed signal as from the Savitzky-Golay filter without sending it through the chain
+			double level = 0;
+			double derivative = 0;
+			bool smoothed = false;
+			{
+				auto stage = metrics.stage(detection::NStage::Smoothing);
+				data.signal.push_back(event.level(), event.device_time());
+				smoothed = savgol.apply(data.signal, level, derivative);
+			}
+			if (smoothed) {
+				//with a slope signal, the slope is the derivative of the fit (as from the Savitzky-Golay filter)
+				data.slope = derivative;
+				if (smooth_output && slope_signal != scgms::signal_Null) {
+					auto rc = send_smoothed(detection::signal_savgol_derivative, event, derivative);
+					if (!Succeeded(rc)) {
+						return rc;
+					}
+				}
 
-		//activation event
-		scgms::UDevice_Event event_act(scgms::NDevice_Event_Code::Level);
-		event_act.device_id() = detection::id_cho;
-		event_act.signal_id() = detection::signal_activation;
-		event_act.segment_id() = event.segment_id();
-		event_act.device_time() = event.device_time();
-
-		//event of detected cho
-		scgms::UDevice_Event event_cho(scgms::NDevice_Event_Code::Level);
-		event_cho.device_id() = detection::id_cho;
-		event_cho.segment_id() = event.segment_id();
-		event_cho.device_time() = event.device_time();
-		event_cho.signal_id() = detection::signal_cho;
-		event_cho.level() = 0;
-
-		double act = 0;
-		if (detect_edges) {
-			//calc activation
-			act = activation(event, it->second);
+				auto rc = detect(seg_id, event.device_time(), level, data);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
+
+				if (smooth_output) {
+					rc = send_smoothed(detection::signal_savgol, event, level);
+					if (!Succeeded(rc)) {
+						return rc;
+					}
+				}
+			}
+		}
+	}
+	else if (event.is_level_event() && slope_signal != scgms::signal_Null && event.signal_id() == slope_signal && !smooth) {
+		auto& data = mSegments.get(event.segment_id(), event.device_time(), [this]() { return create_segment(); });
+		data.slope = event.level();
+	}
+	else if (event.event_code() == scgms::NDevice_Event_Code::Time_Segment_Stop){
+			mSegments.erase(event.segment_id());
+			rnnSegments.erase(event.segment_id());
+			metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+	}
+
+	return metrics.send(mOutput, event);
+}
+
+CHOSegmentData CCho_Detection::create_segment() const
+{
+	return CHOSegmentData{ false, -1, -1,
+		std::vector<activation_window>(ensemble.size(), activation_window(window_size, gap_size)),
+		std::vector<activation_window>(ensemble.size(), activation_window(window_size, gap_size)),
+		SavgolSegmentData(smooth ? savgol.size() : 0), 0,
+		std::vector<detection::TEmission_State>(ensemble.size()),
+		std::vector<detection::TEmission_State>(ensemble.size()) };
+}
+
+void CHOEnsemble::clear()
+{
+	der_low.clear();
+	weight_low.clear();
+	der_high.clear();
+	weight_high.clear();
+	descending.clear();
+	position_thresholds.clear();
+	activation_signal.clear();
+	cho_signal.clear();
+}
+
+void CHOEnsemble::add(const std::vector<double>& thresholds_and_weights, double th_act, bool desc, size_t window_size)
+{
+	const size_t index = size();
+	der_low.push_back(thresholds_and_weights[0]);
+	weight_low.push_back(thresholds_and_weights[1]);
+	der_high.push_back(thresholds_and_weights[2]);
+	weight_high.push_back(thresholds_and_weights[3]);
+	descending.push_back(desc ? 1 : 0);
+
+	//activations are sums of tenths, the tolerance keeps values equal to the threshold independent of the rounding of the sum
+	std::vector<double> thresholds(window_size);
+	for (size_t i = 0; i < window_size; ++i) {
+		thresholds[i] = th_act + 0.2 * i - 1e-9;
+	}
+	position_thresholds.push_back(std::move(thresholds));
+
+	activation_signal.push_back(detection::ensemble_signal(detection::signal_activation, index));
+	cho_signal.push_back(detection::ensemble_signal(detection::signal_cho, index));
+}
+
+HRESULT CCho_Detection::send_smoothed(const GUID& signal_id, scgms::UDevice_Event& event, double level)
+{
+	auto e = detection::level_event(detection::id_cho, signal_id, event.segment_id(), event.device_time(), level);
+	metrics.emitted();
+	return metrics.send(mOutput, e);
+}
+
+HRESULT CCho_Detection::detect(uint64_t segment_id, double device_time, double level, CHOSegmentData& data)
+{
+	if (detect_edges) {
+		//calc activation
+		activation(segment_id, device_time, level, data);
+	}
 
+	float res = 0;
+	if(use_rnn)
+	{
+		rnn& rnn = rnnSegments.get(segment_id, device_time, []() { return ::rnn(24, 3); });
+		auto stage = metrics.stage(detection::NStage::RNN);
+		res = rnn.predict(segment_id, device_time, level);
+	}
+
+	//RNN is common to the configurations, without edges there is only the RNN detection
+	const size_t count = detect_edges ? ensemble.size() : 1;
+	for (size_t c = 0; c < count; ++c) {
+		//level of detected cho, events are created only when they are sent
+		double cho = 0;
+
+		if (detect_edges) {
 			//send activation
-			event_act.level() = act;
-			auto rc = mOutput.Send(event_act);
-			if (!Succeeded(rc)) {
-				return rc;
+			if (activation_output.emit(data.emitted_activation[c], device_time, act[c])) {
+				auto event_act = detection::level_event(detection::id_cho, ensemble.activation_signal[c], segment_id, device_time, act[c]);
+				metrics.emitted();
+				auto rc = metrics.send(mOutput, event_act);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
 			}
 
-			if (!use_rnn && act > th_high) { //only without RNN 
-				event_cho.level() = 2;
+			if (!use_rnn && act[c] > th_high) { //only without RNN 
+				cho = 2;
 			}
-			else if (act > th_low) {
-				event_cho.level() = 1;
+			else if (act[c] > th_low) {
+				cho = 1;
 			}
 		}
 
 		if(use_rnn)
 		{
-			auto it_rnn = rnnSegments.find(seg_id);
-			if (it_rnn == rnnSegments.end()) {
-				it_rnn = rnnSegments.emplace(seg_id, rnn(24, 3)).first;
-			}
-			rnn& rnn = it_rnn->second;
-
-			float res = rnn.predict((event));
 			if (res > th_rnn) {
 				if (detect_edges) { //confirmation for edges
-					event_cho.level() += 1;
+					cho += 1;
 				}
 				else { //use only RNN
-					event_cho.level() = 2;
+					cho = 2;
 				}
 			}
 
 			//send activation
-			if (!detect_edges) {
-				event_act.level() = res;
-				auto rc = mOutput.Send(event_act);
+			if (!detect_edges && activation_output.emit(data.emitted_activation[c], device_time, res)) {
+				auto event_act = detection::level_event(detection::id_cho, ensemble.activation_signal[c], segment_id, device_time, res);
+				metrics.emitted();
+				auto rc = metrics.send(mOutput, event_act);
 				if (!Succeeded(rc)) {
 					return rc;
 				}
 			}
 		}
 
-		auto rc = mOutput.Send(event_cho);
-		if (!Succeeded(rc)) {
-			return rc;
+		if (detection_output.emit(data.emitted_cho[c], device_time, cho)) {
+			auto event_cho = detection::level_event(detection::id_cho, ensemble.cho_signal[c], segment_id, device_time, cho);
+			metrics.emitted();
+			auto rc = metrics.send(mOutput, event_cho);
+			if (!Succeeded(rc)) {
+				return rc;
+			}
 		}
 	}
-	else if (event.event_code() == scgms::NDevice_Event_Code::Time_Segment_Stop){
-			mSegments.erase(event.segment_id());
+
+	return S_OK;
+}
+
+size_t CCho_Detection::state_size() const
+{
+	return mSegments.size() * (sizeof(CHOSegmentData) + (2 * ensemble.size() * window_size + (smooth ? 2 * savgol.size() : 0)) * sizeof(double)) + rnnSegments.size() * (sizeof(rnn) + 24 * 3 * sizeof(float));
+}
+
+bool CCho_Detection::save_state() const
+{
+	detection::CState_Snapshot state(detection::id_cho);
+	state.write(static_cast<uint64_t>(window_size));
+	state.write(static_cast<uint64_t>(smooth ? savgol_window : 0));
+	state.write(static_cast<uint64_t>(ensemble.size()));
+
+	state.write(static_cast<uint64_t>(mSegments.size()));
+	mSegments.for_each([&state](uint64_t seg_id, double last_time, const CHOSegmentData& data) {
+		state.write(seg_id);
+		state.write(last_time);
+		state.write(data.initialized);
+		state.write(data.prevL);
+		state.write(data.prevT);
+		for (size_t c = 0; c < data.activation.size(); ++c) {
+			state.write(data.activation[c].values());
+			state.write(data.activation_m[c].values());
+		}
+		state.write(data.signal.levels);
+		state.write(data.signal.times);
+		state.write(data.slope);
+		for (size_t c = 0; c < data.emitted_activation.size(); ++c) {
+			state.write(data.emitted_activation[c].level);
+			state.write(data.emitted_activation[c].time);
+			state.write(data.emitted_cho[c].level);
+			state.write(data.emitted_cho[c].time);
+		}
+	});
+
+	state.write(static_cast<uint64_t>(rnnSegments.size()));
+	rnnSegments.for_each([&state](uint64_t seg_id, double last_time, const rnn& data) {
+		state.write(seg_id);
+		state.write(last_time);
+		data.save_state(state);
+	});
+
+	return state.save(snapshot.path());
+}
+
+void CCho_Detection::restore_state()
+{
+	mSegments.clear();
+	rnnSegments.clear();
+
+	detection::CState_Snapshot state(detection::id_cho);
+	if (!snapshot.enabled() || !state.load(snapshot.path()) || state.read_uint() != window_size || state.read_uint() != (smooth ? savgol_window : 0) || state.read_uint() != ensemble.size()) {
+		return;
+	}
+
+	uint64_t count = state.read_uint();
+	for (uint64_t i = 0; i < count && state.good(); ++i) {
+		const uint64_t seg_id = state.read_uint();
+		const double last_time = state.read_double();
+		CHOSegmentData data = create_segment();
+		data.initialized = state.read_bool();
+		data.prevL = state.read_double();
+		data.prevT = state.read_double();
+		for (size_t c = 0; c < ensemble.size(); ++c) {
+			for (auto window : { &data.activation[c], &data.activation_m[c] }) {
+				//the incremental state of the window is rebuilt from its values
+				swl<double> values(window_size);
+				state.read(values);
+				for (double value : values) window->push(value, ensemble.position_thresholds[c]);
+			}
+		}
+		state.read(data.signal.levels);
+		state.read(data.signal.times);
+		data.slope = state.read_double();
+		for (size_t c = 0; c < ensemble.size(); ++c) {
+			data.emitted_activation[c].level = state.read_double();
+			data.emitted_activation[c].time = state.read_double();
+			data.emitted_cho[c].level = state.read_double();
+			data.emitted_cho[c].time = state.read_double();
+		}
+		mSegments.insert(seg_id, last_time, std::move(data));
 	}
 
-	return mOutput.Send(event);
+	count = state.read_uint();
+	for (uint64_t i = 0; i < count && state.good(); ++i) {
+		const uint64_t seg_id = state.read_uint();
+		const double last_time = state.read_double();
+		rnn data(24, 3);
+		data.load_state(state);
+		rnnSegments.insert(seg_id, last_time, std::move(data));
+	}
+
+	if (!state.finished()) {
+		mSegments.clear();
+		rnnSegments.clear();
+	}
 }
 
-double CCho_Detection::activation(scgms::UDevice_Event& event, CHOSegmentData& data)
+void CCho_Detection::activation(uint64_t segment_id, double device_time, double level, CHOSegmentData& data)
 {
+	detection::trace::CSpan span("CCho_Detection::activation", segment_id, device_time);
+	auto stage = metrics.stage(detection::NStage::Activation);
+
+	const size_t count = ensemble.size();
+
 	//initializations
 	if (!data.initialized) {
 		data.initialized = true;
-		data.prevL = event.level();
-		data.prevT = event.device_time();
-		return 0;
+		data.prevL = level;
+		data.prevT = device_time;
+		std::fill(act.begin(), act.end(), 0.0);
+		return;
 	}
 
-	double time = (event.device_time() - data.prevT) / scgms::One_Minute;
-	double der = (event.level() - data.prevL) / time;
-
-	//get weight of the signal
-	double act = 0;
-	double act_m = 0;
-	for (size_t i = 0; i < thresholds.size(); ++i) {
-		if (der > thresholds[i]) act = weights[i];
-		if (der < -1 * thresholds[i]) act_m = -1 * weights[i];
+	double der = data.slope;
+	if (slope_signal == scgms::signal_Null) {
+		double time = (device_time - data.prevT) / scgms::One_Minute;
+		der = (level - data.prevL) / time;
 	}
 
-	//ascending edge
-	if (act >= weights[0]) {
-		for (size_t i = 0; i < data.activation.size(); ++i) {
-			if (data.activation.at(i) >= th_act + 0.2 * i) {
-				act += 0.1 * i;
-			}
-		}
+	//get weight of the signal, the shared derivative against all configurations without branches
+	const double* der_low = ensemble.der_low.data();
+	const double* weight_low = ensemble.weight_low.data();
+	const double* der_high = ensemble.der_high.data();
+	const double* weight_high = ensemble.weight_high.data();
+	double* a = act.data();
+	double* a_m = act_m.data();
+	for (size_t c = 0; c < count; ++c) {
+		const double low = der > der_low[c] ? weight_low[c] : 0.0;
+		a[c] = der > der_high[c] ? weight_high[c] : low;
+		const double low_m = der < -1 * der_low[c] ? -1 * weight_low[c] : 0.0;
+		a_m[c] = der < -1 * der_high[c] ? -1 * weight_high[c] : low_m;
 	}
-	//descending edge
-	else if (detect_desc && act_m <= -1 * weights[0]) {
-		if (data.activation.size() > gap_size) {
-			act = *std::max_element(data.activation.begin(), data.activation.begin() + gap_size);
-		}
-		else {
-			act = *std::max_element(data.activation.begin(), data.activation.end());
-		}
 
-		for (size_t i = 0; i < data.activation_m.size(); ++i) {
-			if (data.activation_m.at(i) <= -1 * (th_act + i * 0.2)) {
-				act -= 0.1 * i;
-				act_m -= 0.1 * i;
+	for (size_t c = 0; c < count; ++c) {
+		auto& activation = data.activation[c];
+		auto& activation_m = data.activation_m[c];
+
+		//ascending edge
+		if (a[c] >= weight_low[c]) {
+			a[c] += 0.1 * activation.position_sum();
+		}
+		//descending edge
+		else if (ensemble.descending[c] && a_m[c] <= -1 * weight_low[c]) {
+			if (!activation.empty()) {
+				a[c] = activation.max();
 			}
+
+			const double descending = 0.1 * activation_m.position_sum();
+			a[c] -= descending;
+			a_m[c] -= descending;
 		}
-	}
 
-	//store values
-	data.activation.push_front(act);
-	data.activation_m.push_front(act_m);
+		//store values
+		activation.push(a[c], ensemble.position_thresholds[c]);
+		activation_m.push(-a_m[c], ensemble.position_thresholds[c]);
+	}
 
-	data.prevL = event.level();
-	data.prevT = event.device_time();
-	
-	return act;
+	data.prevL = level;
+	data.prevT = device_time;
 }
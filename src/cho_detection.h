@@ -58,6 +58,12 @@
 
 #include "descriptor.h"
 #include "swl.h"
+#include "activation_window.h"
+#include "segment_store.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "emission.h"
+#include "savgol_filter.h"
 #include "ML/rnn.h"
 
 #pragma warning( push )
@@ -68,8 +74,40 @@ struct CHOSegmentData {
 	double prevL = -1;
 	double prevT = -1;
 
-	swl<double> activation;
-	swl<double> activation_m;
+	//windows of each configuration of the ensemble
+	std::vector<activation_window> activation;
+	//magnitudes of the descending activations
+	std::vector<activation_window> activation_m;
+
+	//input window of the fused smoothing
+	SavgolSegmentData signal;
+	//slope of the last sample from the slope signal
+	double slope = 0;
+
+	//last sent activation and detection of each configuration
+	std::vector<detection::TEmission_State> emitted_activation;
+	std::vector<detection::TEmission_State> emitted_cho;
+};
+
+/*Detector configurations evaluated side by side, one array per setting (structure of arrays)
+ * Configuration 0 is given by the filter parameters, the others by the ensemble parameter.
+ */
+struct CHOEnsemble {
+	std::vector<double> der_low;
+	std::vector<double> weight_low;
+	std::vector<double> der_high;
+	std::vector<double> weight_high;
+	std::vector<uint8_t> descending;
+	//threshold of the activation at each position of the window (th_act + 0.2 * i)
+	std::vector<std::vector<double>> position_thresholds;
+
+	//output signals of the configurations
+	std::vector<GUID> activation_signal;
+	std::vector<GUID> cho_signal;
+
+	size_t size() const { return der_low.size(); }
+	void clear();
+	void add(const std::vector<double>& thresholds_and_weights, double th_act, bool desc, size_t window_size);
 };
 
 /*Filter for carbohydrates detection*/
@@ -85,27 +123,57 @@ public:
 	virtual HRESULT IfaceCalling QueryInterface(const GUID*  riid, void ** ppvObj) override final;
 
 private:
-	std::map<uint64_t, CHOSegmentData> mSegments;
+	segment_store<CHOSegmentData> mSegments;
 
 	GUID input_signal = detection::signal_savgol;
+	//derivative of the input signal, signal_Null = difference of two samples
+	GUID slope_signal = scgms::signal_Null;
 	bool detect_edges = true;
-	bool detect_desc = false;
 
 	size_t window_size = 12;
 	size_t gap_size = 6;
-	double th_act = 2;
 	double th_low = 3;
 	double th_high = 5.5;
 
-	std::vector<double> thresholds = { 0.0125, 0.018 };
-	std::vector<double> weights = { 2.25, 3 };
+	CHOEnsemble ensemble;
+	//activations of the current sample for each configuration
+	std::vector<double> act;
+	std::vector<double> act_m;
+
+	//fused Savitzky-Golay smoothing of the input signal
+	bool smooth = false;
+	bool smooth_output = false;
+	size_t savgol_window = 21;
+	size_t savgol_degree = 3;
+	detection::CSavgol_Coefficients savgol;
 
 	bool use_rnn = false;
 	double th_rnn = 45;
-	std::map<uint64_t, rnn> rnnSegments;
+	segment_store<rnn> rnnSegments;
+
+	//output policies of the activation and the detected cho
+	detection::CEmission_Policy activation_output;
+	detection::CEmission_Policy detection_output;
+
+	detection::CFilter_Metrics metrics{ L"CHO detection" };
+	/*Approximate size of the segment state in bytes*/
+	size_t state_size() const;
+
+	detection::CSnapshot_Schedule snapshot;
+	/*Write the segment state to the snapshot file*/
+	bool save_state() const;
+	/*Restore the segment state from the snapshot file, cold start if the snapshot is missing or does not match*/
+	void restore_state();
+
+	CHOSegmentData create_segment() const;
+	/*Smoothed signal of the fused smoothing*/
+	HRESULT send_smoothed(const GUID& signal_id, scgms::UDevice_Event& event, double level);
+
+	/*Detection of one sample of the (smoothed) signal, sends activation and detected cho*/
+	HRESULT detect(uint64_t segment_id, double device_time, double level, CHOSegmentData& data);
 
-	/*Calc activation function*/
-	double activation(scgms::UDevice_Event& event, CHOSegmentData &data);
+	/*Calc activation function of all configurations to act*/
+	void activation(uint64_t segment_id, double device_time, double level, CHOSegmentData &data);
 };
 
 
@@ -55,6 +55,7 @@
 #include "savgol_filter.h"
 #include "evaluation.h"
 #include "pa_detection.h"
+#include "async_filter.h"
 
 #include <iface/DeviceIface.h>
 #include <iface/FilterIface.h>
@@ -64,6 +65,7 @@
 #include <utils/descriptor_utils.h>
 
 #include <array>
+#include <utility>
 
 /*
  * Example filter descriptor block
@@ -72,52 +74,106 @@
 namespace detection {
 
 	//CHO detection filter
-	constexpr size_t cho_param_count = 9;
+	constexpr size_t cho_param_count = 23;
 
 	const scgms::NParameter_Type cho_param_type[cho_param_count] = {
+		scgms::NParameter_Type::ptSignal_Id,
 		scgms::NParameter_Type::ptSignal_Id,
 		scgms::NParameter_Type::ptInt64,
 		scgms::NParameter_Type::ptDouble_Array,
 		scgms::NParameter_Type::ptBool,
 		scgms::NParameter_Type::ptBool,
 		scgms::NParameter_Type::ptDouble,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptDouble,
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
 		scgms::NParameter_Type::ptBool,
 		scgms::NParameter_Type::ptWChar_Array,
-		scgms::NParameter_Type::ptDouble
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptInt64
 	};
 
 	const wchar_t* cho_ui_param_name[cho_param_count] = {
 		L"Signal",
+		L"Slope signal",
 		L"Window size",
 		L"Thresholds",
 		L"Detect edges",
 		L"Detect descending edges",
 		L"Rise threshold",
+		L"Ensemble configurations",
 		L"Use RNN",
 		L"RNN model file path",
-		L"RNN threshold"
+		L"RNN threshold",
+		L"Smooth signal",
+		L"Savgol window size",
+		L"Savgol degree",
+		L"Send smoothed signal",
+		L"Activation output",
+		L"Detection output",
+		L"Output heartbeat (min)",
+		L"Metrics period (min)",
+		L"Segment TTL (min)",
+		L"Max segments",
+		L"Snapshot file path",
+		L"Snapshot period (min)"
 	};
 
 	const wchar_t* rsSignal = L"signal";
+	const wchar_t* rsSlopeSignal = L"slope_signal";
 	const wchar_t* rsWindowSize = L"window_size";
 	const wchar_t* rsThresholds = L"thresholds";
 	const wchar_t* rsEdges = L"edges";
 	const wchar_t* rsDesc = L"descending";
 	const wchar_t* rsThAct = L"th_act";
+	const wchar_t* rsEnsemble = L"ensemble";
 	const wchar_t* rsRnn = L"rnn";
 	const wchar_t* rsModelPath = L"model_path";
 	const wchar_t* rsRnnThreshold = L"th_rnn";
+	const wchar_t* rsSmooth = L"smooth";
+	const wchar_t* rsSmoothOutput = L"smooth_output";
+	const wchar_t* rsActivationOutput = L"activation_output";
+	const wchar_t* rsDetectionOutput = L"detection_output";
+	const wchar_t* rsOutputHeartbeat = L"output_heartbeat";
+	const wchar_t* rsMetricsPeriod = L"metrics_period";
+	const wchar_t* rsSegmentTTL = L"segment_ttl";
+	const wchar_t* rsMaxSegments = L"max_segments";
+	const wchar_t* rsSnapshotPath = L"snapshot_path";
+	const wchar_t* rsSnapshotPeriod = L"snapshot_period";
 
 	const wchar_t* cho_config_param_name[cho_param_count] = {
 		rsSignal,
+		rsSlopeSignal,
 		rsWindowSize,
 		rsThresholds,
 		rsEdges,
 		rsDesc,
 		rsThAct,
+		rsEnsemble,
 		rsRnn,
 		rsModelPath,
-		rsRnnThreshold
+		rsRnnThreshold,
+		rsSmooth,
+		rsSavgolWindow,
+		rsSavgolDeg,
+		rsSmoothOutput,
+		rsActivationOutput,
+		rsDetectionOutput,
+		rsOutputHeartbeat,
+		rsMetricsPeriod,
+		rsSegmentTTL,
+		rsMaxSegments,
+		rsSnapshotPath,
+		rsSnapshotPeriod
 	};
 	
 	const scgms::TFilter_Descriptor cho_descriptor = {
@@ -160,28 +216,47 @@ namespace detection {
 	};
 
 	//Savitzky-Golay filter
-	constexpr size_t savgol_param_count = 3;
+	constexpr size_t savgol_param_count = 9;
 
 	const scgms::NParameter_Type savgol_param_type[savgol_param_count] = {
 		scgms::NParameter_Type::ptSignal_Id,
 		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptWChar_Array,
 		scgms::NParameter_Type::ptInt64
 	};
 
 	const wchar_t* savgol_ui_param_name[savgol_param_count] = {
 		L"Signal",
 		L"Window size",
-		L"Degree"
+		L"Degree",
+		L"Send derivative",
+		L"Metrics period (min)",
+		L"Segment TTL (min)",
+		L"Max segments",
+		L"Snapshot file path",
+		L"Snapshot period (min)"
 	};
 
 	extern const wchar_t* rsSavgolSignal = L"savgol_signal";
 	extern const wchar_t* rsSavgolWindow = L"savgol_window";
 	extern const wchar_t* rsSavgolDeg = L"savgol_degree";
+	extern const wchar_t* rsSavgolDerivative = L"savgol_derivative";
 
 	const wchar_t* savgol_config_param_name[savgol_param_count] = {
 		rsSavgolSignal,
 		rsSavgolWindow,
-		rsSavgolDeg
+		rsSavgolDeg,
+		rsSavgolDerivative,
+		rsMetricsPeriod,
+		rsSegmentTTL,
+		rsMaxSegments,
+		rsSnapshotPath,
+		rsSnapshotPeriod
 	};
 
 	const scgms::TFilter_Descriptor savgol_descriptor = {
@@ -196,7 +271,7 @@ namespace detection {
 	};
 
 	//evaluation filter
-	constexpr size_t eval_param_count = 6;
+	constexpr size_t eval_param_count = 12;
 
 	const scgms::NParameter_Type eval_param_type[eval_param_count] = {
 		scgms::NParameter_Type::ptSignal_Id,
@@ -204,6 +279,12 @@ namespace detection {
 		scgms::NParameter_Type::ptInt64,
 		scgms::NParameter_Type::ptInt64,
 		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptWChar_Array,
 		scgms::NParameter_Type::ptInt64
 	};
 
@@ -213,7 +294,13 @@ namespace detection {
 		L"Max detection delay (min)",
 		L"False positive cooldown",
 		L"Late detection delay",
-		L"Min reference count"
+		L"Min reference count",
+		L"Threshold sweep",
+		L"Statistics output file path",
+		L"Offline matching",
+		L"Metrics period (min)",
+		L"Snapshot file path",
+		L"Snapshot period (min)"
 	};
 
 	extern const wchar_t* rsSignalRef = L"ref_signal";
@@ -222,6 +309,9 @@ namespace detection {
 	extern const wchar_t* rsFPDelay = L"fp_delay";
 	extern const wchar_t* rsLateDelay = L"late_delay";
 	extern const wchar_t* rsMinRef = L"min_ref";
+	extern const wchar_t* rsThresholdSweep = L"threshold_sweep";
+	extern const wchar_t* rsStatisticsPath = L"statistics_path";
+	extern const wchar_t* rsOfflineMatching = L"offline_matching";
 
 	const wchar_t* eval_config_param_name[eval_param_count] = {
 		rsSignalRef,
@@ -229,7 +319,13 @@ namespace detection {
 		rsMaxDelay,
 		rsFPDelay,
 		rsLateDelay,
-		rsMinRef
+		rsMinRef,
+		rsThresholdSweep,
+		rsStatisticsPath,
+		rsOfflineMatching,
+		rsMetricsPeriod,
+		rsSnapshotPath,
+		rsSnapshotPeriod
 	};
 	
 	const scgms::TFilter_Descriptor eval_descriptor = {
@@ -244,7 +340,7 @@ namespace detection {
 	};
 
 	//PA detection filter
-	constexpr size_t pa_param_count = 10;
+	constexpr size_t pa_param_count = 30;
 
 	const scgms::NParameter_Type pa_param_type[pa_param_count] = {
 		scgms::NParameter_Type::ptBool,
@@ -254,11 +350,34 @@ namespace detection {
 
 		scgms::NParameter_Type::ptBool,
 		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptWChar_Array,
 
 		scgms::NParameter_Type::ptBool,
 		scgms::NParameter_Type::ptSignal_Id,
 		scgms::NParameter_Type::ptInt64,
 		scgms::NParameter_Type::ptDouble_Array,
+
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptBool,
+		scgms::NParameter_Type::ptSignal_Id,
+		scgms::NParameter_Type::ptWChar_Array,
+
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptInt64,
+
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptWChar_Array,
+		scgms::NParameter_Type::ptInt64
 	};
 
 	const wchar_t* pa_ui_param_name[pa_param_count] = {
@@ -269,11 +388,34 @@ namespace detection {
 
 		L"Mean",
 		L"Window size - mean",
+		L"Window length - mean (min)",
+		L"Alignment bin (s)",
+		L"Alignment bin mean",
+		L"Acceleration bin (s)",
+		L"Acceleration resolutions (min)",
 
 		L"Detect IST edges",
 		L"Signal",
 		L"Window size - edges",
-		L"Thresholds"
+		L"Thresholds",
+
+		L"Classifier",
+		L"Classifier type",
+		L"Classifier training data",
+		L"Classifier model file path",
+		L"Classifier online learning",
+		L"Activity label signal",
+		L"Feature export file path",
+
+		L"Activation output",
+		L"Detection output",
+		L"Output heartbeat (min)",
+
+		L"Metrics period (min)",
+		L"Segment TTL (min)",
+		L"Max segments",
+		L"Snapshot file path",
+		L"Snapshot period (min)"
 	};
 
 	extern const wchar_t* rsSHeartbeat = L"b_heart";
@@ -282,6 +424,18 @@ namespace detection {
 	extern const wchar_t* rsSEl = L"b_el";
 	extern const wchar_t* rsMean = L"mean";
 	extern const wchar_t* rsMeanSize = L"mean_size";
+	extern const wchar_t* rsMeanDuration = L"mean_duration";
+	extern const wchar_t* rsAlignBin = L"align_bin";
+	extern const wchar_t* rsAlignMean = L"align_mean";
+	extern const wchar_t* rsAccBin = L"acc_bin";
+	extern const wchar_t* rsAccResolutions = L"acc_resolutions";
+	extern const wchar_t* rsClass = L"classifier";
+	extern const wchar_t* rsClassType = L"class_type";
+	extern const wchar_t* rsClassData = L"class_data";
+	extern const wchar_t* rsClassModel = L"class_model";
+	extern const wchar_t* rsOnline = L"online";
+	extern const wchar_t* rsLabelSignal = L"label_signal";
+	extern const wchar_t* rsExportPath = L"export_path";
 
 	const wchar_t* pa_config_param_name[pa_param_count] = {
 		rsSHeartbeat,
@@ -291,11 +445,34 @@ namespace detection {
 
 		rsMean,
 		rsMeanSize,
+		rsMeanDuration,
+		rsAlignBin,
+		rsAlignMean,
+		rsAccBin,
+		rsAccResolutions,
 
 		rsDesc,
 		rsSignal,
 		rsWindowSize,
-		rsThresholds
+		rsThresholds,
+
+		rsClass,
+		rsClassType,
+		rsClassData,
+		rsClassModel,
+		rsOnline,
+		rsLabelSignal,
+		rsExportPath,
+
+		rsActivationOutput,
+		rsDetectionOutput,
+		rsOutputHeartbeat,
+
+		rsMetricsPeriod,
+		rsSegmentTTL,
+		rsMaxSegments,
+		rsSnapshotPath,
+		rsSnapshotPeriod
 	};
 
 	const scgms::TFilter_Descriptor pa_descriptor = {
@@ -344,28 +521,73 @@ namespace detection {
 			&scgms::signal_Null
 	};
 
+	//asynchronous queue filter
+	constexpr size_t async_param_count = 2;
+
+	const scgms::NParameter_Type async_param_type[async_param_count] = {
+		scgms::NParameter_Type::ptInt64,
+		scgms::NParameter_Type::ptInt64
+	};
+
+	const wchar_t* async_ui_param_name[async_param_count] = {
+		L"Queue size",
+		L"Batch size"
+	};
+
+	extern const wchar_t* rsQueueSize = L"queue_size";
+	extern const wchar_t* rsBatchSize = L"batch_size";
+
+	const wchar_t* async_config_param_name[async_param_count] = {
+		rsQueueSize,
+		rsBatchSize
+	};
+
+	const scgms::TFilter_Descriptor async_descriptor = {
+		id_async,
+		scgms::NFilter_Flags::None,
+		L"Asynchronous queue",
+		async_param_count,
+		async_param_type,
+		async_ui_param_name,
+		async_config_param_name,
+		nullptr
+	};
+
 	//signal descriptors
 	const scgms::TSignal_Descriptor activation_desc{ signal_activation, L"Activation", L"", scgms::NSignal_Unit::Other, 0xFFFF0000, 0xFFFF0000, scgms::NSignal_Visualization::smooth, scgms::NSignal_Mark::none, nullptr };
 	const scgms::TSignal_Descriptor cho_desc{ signal_cho, L"CHO probability", L"", scgms::NSignal_Unit::Other, 0xFFFF0000, 0xFFFF0000, scgms::NSignal_Visualization::step, scgms::NSignal_Mark::cross, nullptr };
 	const scgms::TSignal_Descriptor savgol_desc{ signal_savgol, L"Savgol signal", dsmmol_per_L, scgms::NSignal_Unit::mmol_per_L, 0xFFFF0000, 0xFFFF0000, scgms::NSignal_Visualization::smooth, scgms::NSignal_Mark::none, nullptr };
+	const scgms::TSignal_Descriptor savgol_derivative_desc{ signal_savgol_derivative, L"Savgol derivative", L"mmol/L/min", scgms::NSignal_Unit::Other, 0xFFFF0000, 0xFFFF0000, scgms::NSignal_Visualization::smooth, scgms::NSignal_Mark::none, nullptr };
 	const scgms::TSignal_Descriptor pa_desc{ signal_pa, L"PA detected", L"", scgms::NSignal_Unit::Other, 0xFFFF0000, 0xFFFF0000, scgms::NSignal_Visualization::step, scgms::NSignal_Mark::cross, nullptr };
+
+	//signals of the ensemble configurations 1 .. max_ensemble - 1
+	const wchar_t* ensemble_activation_names[max_ensemble - 1] = { L"Activation 1", L"Activation 2", L"Activation 3", L"Activation 4", L"Activation 5", L"Activation 6", L"Activation 7" };
+	const wchar_t* ensemble_cho_names[max_ensemble - 1] = { L"CHO probability 1", L"CHO probability 2", L"CHO probability 3", L"CHO probability 4", L"CHO probability 5", L"CHO probability 6", L"CHO probability 7" };
+
+	scgms::TSignal_Descriptor ensemble_desc(const scgms::TSignal_Descriptor& desc, size_t index, const wchar_t* name) {
+		return { ensemble_signal(desc.id, index), name, desc.unit_description, desc.unit, desc.fill_color, desc.stroke_color, desc.visualization, desc.mark, nullptr };
+	}
+
+	template <size_t... K>
+	std::array<scgms::TSignal_Descriptor, 5 + 2 * sizeof...(K)> signal_descriptors(std::index_sequence<K...>) {
+		return { { activation_desc, savgol_desc, savgol_derivative_desc, cho_desc, pa_desc,
+			ensemble_desc(activation_desc, K + 1, ensemble_activation_names[K])...,
+			ensemble_desc(cho_desc, K + 1, ensemble_cho_names[K])... } };
+	}
 }
 
 /*
  * Array of available filter descriptors
  */
 
-const std::array<scgms::TFilter_Descriptor, 4> filter_descriptions = { { detection::cho_descriptor,
+const std::array<scgms::TFilter_Descriptor, 5> filter_descriptions = { { detection::cho_descriptor,
 																		 detection::savgol_descriptor,
 																		 detection::eval_descriptor,
-																		 detection::pa_descriptor
+																		 detection::pa_descriptor,
+																		 detection::async_descriptor
 																	 } };
 
-const std::array<scgms::TSignal_Descriptor, 4> signal_descriptors = { { detection::activation_desc,
-																		detection::savgol_desc,
-																		detection::cho_desc,
-																		detection::pa_desc
-																	} };
+const std::array<scgms::TSignal_Descriptor, 5 + 2 * (detection::max_ensemble - 1)> signal_descriptors = detection::signal_descriptors(std::make_index_sequence<detection::max_ensemble - 1>());
 
 const std::array<scgms::TModel_Descriptor, 2> model_descriptors = { { detection::cho_detect_thresh_and_weights_desc,
 																	  detection::pa_thresholds_desc
@@ -408,5 +630,9 @@ extern "C" HRESULT IfaceCalling do_create_filter(const GUID *id, scgms::IFilter
 		return Manufacture_Object<CPa_Detection>(filter, output);
 	}
 
+	if (*id == detection::async_descriptor.id) {
+		return Manufacture_Object<CAsync_Filter>(filter, output);
+	}
+
 	return E_NOTIMPL;
 }
@@ -61,22 +61,45 @@ namespace detection {
 	constexpr GUID signal_cho ={ 0x2db18d70, 0x5eb1, 0x4d91, { 0x8d, 0xfa, 0xe1, 0x65, 0xe1, 0xb0, 0xc4, 0x77 } }; // {2DB18D70-5EB1-4D91-8DFA-E165E1B0C477}
 
 	extern const wchar_t* rsSignal;
+	extern const wchar_t* rsSlopeSignal;
+
+	/*Number of CHO detection configurations including the default one, the signals of all are registered*/
+	constexpr size_t max_ensemble = 8;
+
+	/*Output signal of the ensemble configuration of CHO detection, configuration 0 uses the signal itself*/
+	inline GUID ensemble_signal(GUID signal, size_t index) {
+		signal.Data4[7] = static_cast<unsigned char>(signal.Data4[7] + index);
+		return signal;
+	}
 	extern const wchar_t* rsWindowSize;
 	extern const wchar_t* rsThresholds;
 	extern const wchar_t* rsThAct;
+	extern const wchar_t* rsEnsemble;
 	extern const wchar_t* rsEdges;
 	extern const wchar_t* rsDesc;
 	extern const wchar_t* rsRnn;
 	extern const wchar_t* rsModelPath;
 	extern const wchar_t* rsRnnThreshold;
+	extern const wchar_t* rsSmooth;
+	extern const wchar_t* rsSmoothOutput;
+	extern const wchar_t* rsActivationOutput;
+	extern const wchar_t* rsDetectionOutput;
+	extern const wchar_t* rsOutputHeartbeat;
+	extern const wchar_t* rsMetricsPeriod;
+	extern const wchar_t* rsSegmentTTL;
+	extern const wchar_t* rsMaxSegments;
+	extern const wchar_t* rsSnapshotPath;
+	extern const wchar_t* rsSnapshotPeriod;
 
 	
 	constexpr GUID id_savgol = { 0xf45103c3, 0xe0e1, 0x4a8d, { 0xae, 0xc4, 0xb9, 0x7c, 0x83, 0x83, 0xf, 0x9f } }; // {F45103C3-E0E1-4A8D-AEC4-B97C83830F9F}
 	constexpr GUID signal_savgol = { 0x94e92903, 0x10fb, 0x4e8b, { 0x95, 0xfc, 0xbe, 0x69, 0x16, 0xdd, 0x54, 0xa7 } }; // {94E92903-10FB-4E8B-95FC-BE6916DD54A7}
+	constexpr GUID signal_savgol_derivative = { 0xf45ccbc1, 0xe680, 0x4a38, { 0x9f, 0xf7, 0x4d, 0xca, 0xfc, 0x34, 0x53, 0xcd } }; // {F45CCBC1-E680-4A38-9FF7-4DCAFC3453CD}
 
 	extern const wchar_t* rsSavgolSignal;
 	extern const wchar_t* rsSavgolWindow;
 	extern const wchar_t* rsSavgolDeg;
+	extern const wchar_t* rsSavgolDerivative;
 
 	
 	constexpr GUID id_eval = { 0xe4b7f5ba, 0xa3ba, 0x4f5e, { 0xb5, 0xa2, 0x3f, 0xee, 0x2b, 0x12, 0xde, 0xe5 } }; // {E4B7F5BA-A3BA-4F5E-B5A2-3FEE2B12DEE5}
@@ -87,6 +110,9 @@ namespace detection {
 	extern const wchar_t* rsFPDelay;
 	extern const wchar_t* rsLateDelay;
 	extern const wchar_t* rsMinRef;
+	extern const wchar_t* rsThresholdSweep;
+	extern const wchar_t* rsStatisticsPath;
+	extern const wchar_t* rsOfflineMatching;
 	
 
 	constexpr GUID id_pa = { 0xe9e99c04, 0xcb72, 0x4272, { 0xb6, 0xa, 0x3, 0x66, 0x47, 0x78, 0x3b, 0x6b } }; // {E9E99C04-CB72-4272-B60A-036647783B6B}
@@ -99,6 +125,24 @@ namespace detection {
 
 	extern const wchar_t* rsMean;
 	extern const wchar_t* rsMeanSize;
+	extern const wchar_t* rsMeanDuration;
+	extern const wchar_t* rsAlignBin;
+	extern const wchar_t* rsAlignMean;
+	extern const wchar_t* rsAccBin;
+	extern const wchar_t* rsAccResolutions;
+	extern const wchar_t* rsClass;
+	extern const wchar_t* rsClassType;
+	extern const wchar_t* rsClassData;
+	extern const wchar_t* rsClassModel;
+	extern const wchar_t* rsOnline;
+	extern const wchar_t* rsLabelSignal;
+	extern const wchar_t* rsExportPath;
+
+
+	constexpr GUID id_async = { 0x2e563124, 0x95b4, 0x4cb9, { 0xa7, 0xe2, 0x53, 0x8, 0x77, 0xd8, 0x58, 0x8a } }; // {2E563124-95B4-4CB9-A7E2-530877D8588A}
+
+	extern const wchar_t* rsQueueSize;
+	extern const wchar_t* rsBatchSize;
 
 	
 
@@ -0,0 +1,130 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+
+#include <limits>
+#include <string>
+
+namespace detection {
+
+	/*Last emitted value of an output signal of a segment*/
+	struct TEmission_State {
+		double level = std::numeric_limits<double>::quiet_NaN();
+		double time = -1;
+	};
+
+	/*Level event derived by the filter
+	 * Derived events are created only right before they are sent, every event costs an allocation
+	 * in the event factory and ownership passes to the next filter, so an event cannot be reused.
+	 */
+	inline scgms::UDevice_Event level_event(const GUID& device_id, const GUID& signal_id, uint64_t segment_id, double device_time, double level) {
+		scgms::UDevice_Event e(scgms::NDevice_Event_Code::Level);
+		e.device_id() = device_id;
+		e.signal_id() = signal_id;
+		e.segment_id() = segment_id;
+		e.device_time() = device_time;
+		e.level() = level;
+		return e;
+	}
+
+	/*Output policy of a derived signal
+	 * all - every value is sent
+	 * change - the value is sent only if it differs from the last sent value
+	 * nonzero - non-zero values and the first zero after them (end of the detection) are sent
+	 * Suppressed values are sent anyway once the heartbeat period passed since the last sent value.
+	 */
+	class CEmission_Policy {
+	public:
+		enum class NMode { All, Change, Non_Zero };
+
+		/*Mode name and heartbeat period in device time (0 - no heartbeat), false for an unknown mode*/
+		bool configure(const std::wstring& name, double heartbeat_period) {
+			heartbeat = heartbeat_period;
+			if (name.empty() || name == L"all") mode = NMode::All;
+			else if (name == L"change") mode = NMode::Change;
+			else if (name == L"nonzero") mode = NMode::Non_Zero;
+			else return false;
+			return heartbeat >= 0;
+		}
+
+		/*Every value is sent, the state does not have to be kept*/
+		bool all() const { return mode == NMode::All; }
+
+		/*Decides whether the value is sent and records the sent value to the state*/
+		bool emit(TEmission_State& state, double time, double level) const {
+			bool send = true;
+			if (mode == NMode::Change) {
+				send = !(state.level == level);
+			}
+			else if (mode == NMode::Non_Zero) {
+				send = level != 0 || (state.time != -1 && state.level != 0);
+			}
+
+			if (!send && heartbeat > 0 && (state.time == -1 || time - state.time >= heartbeat)) {
+				send = true;
+			}
+
+			if (send) {
+				state.level = level;
+				state.time = time;
+			}
+			return send;
+		}
+
+	private:
+		NMode mode = NMode::All;
+		double heartbeat = 0;
+	};
+}
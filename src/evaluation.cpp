@@ -53,6 +53,9 @@
 #include "evaluation.h"
 #include "descriptor.h"
 
+#include <algorithm>
+#include <numeric>
+
 CEvaluation::CEvaluation(scgms::IFilter* output) : CBase_Filter(output) {
 	//
 }
@@ -90,154 +93,613 @@ HRESULT IfaceCalling CEvaluation::Do_Configure(scgms::SFilter_Configuration conf
 	}
 
 	min_ref = (size_t)configuration.Read_Int(detection::rsMinRef, 0);
+
+	//threshold sweep "detection,confirmation;..."
+	sweep.clear();
+	std::wstringstream sweep_configurations(configuration.Read_String(detection::rsThresholdSweep));
+	std::wstring sweep_configuration;
+	while (std::getline(sweep_configurations, sweep_configuration, L';')) {
+		if (sweep_configuration.find_first_not_of(L" \t") == std::wstring::npos) continue;
+
+		double det = -1, conf = -1;
+		wchar_t delim = 0;
+		std::wstringstream values(sweep_configuration);
+		if (!(values >> det >> delim >> conf) || delim != L',' || det < 0 || conf < 0) {
+			error_description.push(L"Cannot read the threshold sweep!");
+			return E_INVALIDARG;
+		}
+		sweep.emplace_back(det, conf);
+	}
+
+	offline = configuration.Read_Bool(detection::rsOfflineMatching);
+
+	metrics.set_period(configuration.Read_Int(detection::rsMetricsPeriod, 0) * scgms::One_Minute);
+	auto output_path = configuration.Read_File_Path(detection::rsStatisticsPath);
+	if (!output_path.empty() && !std::filesystem::is_directory(output_path)) {
+		try {
+			output.open(output_path);
+		}
+		catch (const std::exception&) {
+			error_description.push(L"Cannot open the statistics output file!");
+			return E_INVALIDARG;
+		}
+	}
+
+	data = create_data();
+	metrics.state(1, sizeof(EvalSegmentData) + data.th.size() * (3 * sizeof(StatisticsData) + 4 * sizeof(double) + 3));
+
+	auto snapshot_path = configuration.Read_File_Path(detection::rsSnapshotPath);
+	if (std::filesystem::is_directory(snapshot_path)) snapshot_path.clear();
+	snapshot.configure(snapshot_path, configuration.Read_Int(detection::rsSnapshotPeriod, 0) * scgms::One_Minute);
+	restore_state();
 	
 	return S_OK;
 }
 
 HRESULT IfaceCalling CEvaluation::Do_Execute(scgms::UDevice_Event event) {
-	
-	if (event.is_level_event())
+	auto scope = metrics.measure(event);
+
+	if (metrics.report_due(event.device_time())) {
+		metrics.state(offline ? segments.size() : 1, sizeof(EvalSegmentData));
+		auto report = metrics.report(detection::id_eval, event);
+		auto rc = metrics.send(mOutput, report);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	if (snapshot.due(event) && !save_state()) {
+		auto warning = detection::snapshot_warning(detection::id_eval, event);
+		auto rc = metrics.send(mOutput, warning);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	if (!offline && event.is_level_event())
 	{
 		process_signal(event);
 	}
 	
-	if (event.is_level_event() && event.signal_id() == signal_ref && event.level() > 0) {
+	if (offline) {
+		auto rc = index_event(event);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+	else if (event.is_level_event() && event.signal_id() == signal_ref && event.level() > 0) {
 		process_reference(event);
 	}
 	else if (event.is_level_event() && event.signal_id() == signal_det) {
 		//skip first 3 hours (36)
 		if(data.drop_count++ < th_drop)
 		{
-			return mOutput.Send(event);
+			return metrics.send(mOutput, event);
 		}
 
 		//check date (if new day and ref count > 2 save stat)
 		double d;
-		auto t = std::modf(event.device_time(), &d);
+		std::modf(event.device_time(), &d);
 		if(d > data.date)
 		{
-			data.date = d;
-			if(data.day.count >= min_ref)
-			{
-				data.global += data.day;
+			//days are common to all segments
+			if (output.is_open() && data.date > 0) {
+				auto rc = write_rows(detection::CEvaluation_Output::NKind::Day, 0, data.date, data.th.day);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
 			}
-			data.day = StatisticsData();
+
+			data.date = d;
+			close_day();
 		}
-		
-		auto l = event.level();
 
-		if(true)
 		process_detection(event);
 	}
 	else if (event.event_code() == scgms::NDevice_Event_Code::Time_Segment_Stop) {
-			if (data.day.count >= min_ref)
-			{
-				data.global += data.day;
+			//the last day of the segment is not closed by a detection of the next day
+			if (output.is_open() && data.date > 0) {
+				auto rc = write_rows(detection::CEvaluation_Output::NKind::Day, 0, data.date, data.th.day);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
+			}
+			close_day();
+
+			if (output.is_open()) {
+				auto rc = write_rows(detection::CEvaluation_Output::NKind::Segment, event.segment_id(), event.device_time(), data.th.segment);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
+			}
+			std::fill(data.th.segment.begin(), data.th.segment.end(), StatisticsData());
+
+			auto rc = send_statistics(event.segment_id(), event.device_time());
+			if (!Succeeded(rc)) {
+				return rc;
 			}
+	}
 
-			double acc_d = (double)data.global.TPd / data.global.count;
-			double acc_c = (double)data.global.TPc / data.global.count;
-			double delay = data.global.delay / scgms::One_Minute / data.global.count;
-			double delay_conf = data.global.delay_conf / scgms::One_Minute / data.global.TPc;
+	if (event.event_code() == scgms::NDevice_Event_Code::Shut_Down && output.is_open()) {
+		try {
+			output.close();
+		}
+		catch (...) {
+			return E_FAIL;
+		}
+	}
 
-			scgms::UDevice_Event e(scgms::NDevice_Event_Code::Information);
-			e.device_id() = detection::id_eval;
-			e.signal_id() = Invalid_GUID;
-			e.segment_id() = event.segment_id();
-			e.device_time() = event.device_time();
+	return metrics.send(mOutput, event);
+}
 
-			std::wstringstream stream;
-			stream << L"Ref count: " << data.global.count << L" Accuracy detection: " << acc_d << L", delay: " << delay << L", TP detected: " << data.global.TPd
-				<< L", Accuracy confirmed: " << acc_c << L", confirmation delay: " << delay_conf << L", TP confirmed: " << data.global.TPc
-				<< L", FN: " << data.global.FN << L", FP: " << data.global.FPc;
-			e.info.set(stream.str().c_str());
+HRESULT CEvaluation::send_statistics(uint64_t segment_id, double device_time)
+{
+	const StatisticsData& global = data.th.global[0];
+	double acc_d = (double)global.TPd / global.count;
+	double acc_c = (double)global.TPc / global.count;
+	double delay = global.delay / scgms::One_Minute / global.count;
+	double delay_conf = global.delay_conf / scgms::One_Minute / global.TPc;
+
+	scgms::UDevice_Event e(scgms::NDevice_Event_Code::Information);
+	e.device_id() = detection::id_eval;
+	e.signal_id() = Invalid_GUID;
+	e.segment_id() = segment_id;
+	e.device_time() = device_time;
+
+	std::wstringstream stream;
+	stream << L"Ref count: " << global.count << L" Accuracy detection: " << acc_d << L", delay: " << delay << L", TP detected: " << global.TPd
+		<< L", Accuracy confirmed: " << acc_c << L", confirmation delay: " << delay_conf << L", TP confirmed: " << global.TPc
+		<< L", FN: " << global.FN << L", FP: " << global.FPc;
+	e.info.set(stream.str().c_str());
+
+	metrics.emitted();
+	auto rc = metrics.send(mOutput, e);
+	if (!Succeeded(rc)) {
+		return rc;
+	}
 
-			auto rc = mOutput.Send(e);
+	//statistics of all thresholds of the sweep
+	if (!sweep.empty()) {
+		scgms::UDevice_Event table(scgms::NDevice_Event_Code::Information);
+		table.device_id() = detection::id_eval;
+		table.signal_id() = Invalid_GUID;
+		table.segment_id() = segment_id;
+		table.device_time() = device_time;
+		table.info.set(sweep_table().c_str());
+
+		metrics.emitted();
+		rc = metrics.send(mOutput, table);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT CEvaluation::index_event(scgms::UDevice_Event& event)
+{
+	auto create = []() { return EvalSegmentIndex(); };
+
+	if (event.is_level_event() && event.signal_id() == signal_ref && event.level() > 0) {
+		segments.get(event.segment_id(), event.device_time(), create).references.push_back(event.device_time());
+	}
+	else if (event.is_level_event() && event.signal_id() == signal_det) {
+		auto& segment = segments.get(event.segment_id(), event.device_time(), create);
+		segment.detection_times.push_back(event.device_time());
+		segment.detection_levels.push_back(event.level());
+	}
+	//segments are kept over the shut down (snapshot), so only the stopped ones are matched
+	else if (event.event_code() == scgms::NDevice_Event_Code::Time_Segment_Stop) {
+		return evaluate_segment(event.segment_id(), event.device_time());
+	}
+
+	return S_OK;
+}
+
+HRESULT CEvaluation::evaluate_segment(uint64_t segment_id, double device_time)
+{
+	EvalSegmentIndex* segment = segments.find(segment_id, device_time);
+	if (!segment) {
+		return S_OK;
+	}
+	segment->sort();
+
+	std::map<double, std::vector<StatisticsData>> days;
+	for (size_t i = 0; i < data.th.size(); ++i) {
+		match_segment(*segment, i, days);
+	}
+	segments.erase(segment_id);
+
+	std::vector<StatisticsData> totals(data.th.size());
+	for (const auto& day : days) {
+		if (output.is_open()) {
+			auto rc = write_rows(detection::CEvaluation_Output::NKind::Day, segment_id, day.first, day.second);
 			if (!Succeeded(rc)) {
 				return rc;
 			}
+		}
+		for (size_t i = 0; i < data.th.size(); ++i) {
+			if (day.second[i].count >= min_ref)
+			{
+				totals[i] += day.second[i];
+				data.th.global[i] += day.second[i];
+			}
+		}
 	}
 
-	return mOutput.Send(event);
+	if (output.is_open()) {
+		auto rc = write_rows(detection::CEvaluation_Output::NKind::Segment, segment_id, device_time, totals);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	return send_statistics(segment_id, device_time);
+}
+
+void CEvaluation::match_segment(const EvalSegmentIndex& segment, size_t threshold, std::map<double, std::vector<StatisticsData>>& days) const
+{
+	const double th_det = data.th.detection[threshold];
+	const double th_conf = data.th.confirmation[threshold];
+	const double before = late_delay * scgms::One_Minute;
+	const double after = max_delay * scgms::One_Minute;
+	const double cooldown = fp_delay * scgms::One_Minute;
+
+	const auto& references = segment.references;
+	const auto& times = segment.detection_times;
+	const auto& levels = segment.detection_levels;
+
+	auto day = [&days, threshold, this](double time) -> StatisticsData& {
+		auto& statistics = days[std::floor(time)];
+		if (statistics.empty()) statistics.resize(data.th.size());
+		return statistics[threshold];
+	};
+
+	//skip first detections of the segment (3 hours)
+	const size_t first = std::min(th_drop, times.size());
+
+	//TP/FN - references in order, the start of the window only moves forward
+	//one-to-one matching - a detection (run of values above th_det) is consumed by the earliest reference it fits
+	size_t begin = first;
+	size_t unconsumed = first;
+	for (double ref : references) {
+		StatisticsData& s = day(ref);
+		s.count++;
+
+		while (begin < times.size() && times[begin] < ref - before) begin++;
+		begin = std::max(begin, unconsumed);
+
+		size_t k = begin;
+		while (k < times.size() && times[k] <= ref + after && levels[k] < th_det) k++;
+		if (k == times.size() || times[k] > ref + after) {
+			s.FN++;
+			continue;
+		}
+
+		//detection before the reference (late_delay) has no delay
+		const double detect_time = times[k];
+		s.TPd++;
+		s.delay += std::max(0.0, detect_time - ref);
+
+		unconsumed = k;
+		while (unconsumed < times.size() && levels[unconsumed] >= th_det) unconsumed++;
+
+		while (k < times.size() && times[k] <= ref + after && levels[k] < th_conf) k++;
+		if (k < times.size() && times[k] <= ref + after) {
+			s.TPc++;
+			s.delay_conf += times[k] - detect_time;
+		}
+	}
+
+	//FP - detections outside of all windows, the first reference which window may contain the detection only moves forward
+	size_t ref = 0;
+	double fp_detected = -1;
+	double fp_confirmed = -1;
+	for (size_t k = first; k < times.size(); ++k) {
+		const double t = times[k];
+		while (ref < references.size() && references[ref] < t - after) ref++;
+		if (ref < references.size() && references[ref] <= t + before) continue;
+
+		if (levels[k] >= th_det && (fp_detected < 0 || t - fp_detected > cooldown)) {
+			day(t).FPd++;
+			fp_detected = t;
+		}
+		if (levels[k] >= th_conf && (fp_confirmed < 0 || t - fp_confirmed > cooldown)) {
+			day(t).FPc++;
+			fp_confirmed = t;
+		}
+	}
+}
+
+void EvalSegmentIndex::sort()
+{
+	if (!std::is_sorted(references.begin(), references.end())) {
+		std::sort(references.begin(), references.end());
+	}
+
+	if (!std::is_sorted(detection_times.begin(), detection_times.end())) {
+		std::vector<size_t> order(detection_times.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return detection_times[a] < detection_times[b]; });
+
+		std::vector<double> sorted_times, sorted_levels;
+		sorted_times.reserve(order.size());
+		sorted_levels.reserve(order.size());
+		for (size_t i : order) {
+			sorted_times.push_back(detection_times[i]);
+			sorted_levels.push_back(detection_levels[i]);
+		}
+		detection_times = std::move(sorted_times);
+		detection_levels = std::move(sorted_levels);
+	}
+}
+
+EvalSegmentData CEvaluation::create_data() const
+{
+	EvalSegmentData result;
+	result.th.add(static_cast<double>(th_detection), static_cast<double>(th_confirmation));
+	for (const auto& thresholds : sweep) {
+		result.th.add(thresholds.first, thresholds.second);
+	}
+	return result;
+}
+
+void EvalThresholds::add(double th_detection, double th_confirmation)
+{
+	detection.push_back(th_detection);
+	confirmation.push_back(th_confirmation);
+	detect_time.push_back(0);
+	fp_time.push_back(-1);
+	detected.push_back(0);
+	confirmed.push_back(0);
+	fp.push_back(0);
+	global.emplace_back();
+	segment.emplace_back();
+	day.emplace_back();
+}
+
+std::wstring CEvaluation::sweep_table() const
+{
+	std::wstringstream stream;
+	stream << L"Threshold sweep: detection confirmation ref_count TP_detected TP_confirmed FN FP delay confirmation_delay";
+	for (size_t i = 0; i < data.th.size(); ++i) {
+		const StatisticsData& s = data.th.global[i];
+		const double delay = s.count > 0 ? s.delay / scgms::One_Minute / s.count : 0;
+		const double delay_conf = s.TPc > 0 ? s.delay_conf / scgms::One_Minute / s.TPc : 0;
+		stream << L"\n" << data.th.detection[i] << L" " << data.th.confirmation[i] << L" " << s.count << L" " << s.TPd << L" " << s.TPc
+			<< L" " << s.FN << L" " << s.FPc << L" " << delay << L" " << delay_conf;
+	}
+	return stream.str();
+}
+
+HRESULT CEvaluation::write_rows(detection::CEvaluation_Output::NKind kind, uint64_t segment_id, double time, const std::vector<StatisticsData>& statistics)
+{
+	try {
+		for (size_t i = 0; i < statistics.size(); ++i) {
+			output.write(kind, segment_id, time, i, data.th.detection[i], data.th.confirmation[i], statistics[i]);
+		}
+		output.flush();
+	}
+	catch (const std::exception&) {
+		return E_FAIL;
+	}
+	return S_OK;
+}
+
+void CEvaluation::close_day()
+{
+	for (size_t i = 0; i < data.th.size(); ++i) {
+		if (data.th.day[i].count >= min_ref)
+		{
+			data.th.segment[i] += data.th.day[i];
+			data.th.global[i] += data.th.day[i];
+		}
+		data.th.day[i] = StatisticsData();
+	}
 }
 
 void CEvaluation::process_signal(scgms::UDevice_Event& event)
 {
+	EvalThresholds& th = data.th;
+
 	//reset late detection
 	auto t = (event.device_time() - data.ref_time) / scgms::One_Minute;
 	if (data.ref_time > 0 && t > max_delay) {
-		//if cho not detected
-		if (!data.bDetected) {
-			data.day.FN++;
-		}
+		for (size_t i = 0; i < th.size(); ++i) {
+			//if cho not detected
+			if (!th.detected[i]) {
+				th.day[i].FN++;
+			}
 
+			th.detected[i] = false;
+			th.confirmed[i] = false;
+			th.detect_time[i] = 0;
+		}
 		data.ref_time = -1;
-		data.bDetected = false;
-		data.bConfirmed = false;
-		data.detect_time = 0;
-	}
-	//FP
-	t = (event.device_time() - data.fp_time) / scgms::One_Minute;
-	if (data.ref_time == -1 && data.fp_time > 0 && !data.bFP  && t > late_delay) {
-		data.day.FPc++;
-		data.bFP = true;
 	}
-	//reset FP timer
-	if (data.fp_time > 0 && t > fp_delay) {
-		data.fp_time = -1;
-		data.bFP = false;
+
+	for (size_t i = 0; i < th.size(); ++i) {
+		//FP
+		t = (event.device_time() - th.fp_time[i]) / scgms::One_Minute;
+		if (data.ref_time == -1 && th.fp_time[i] > 0 && !th.fp[i] && t > late_delay) {
+			th.day[i].FPc++;
+			th.fp[i] = true;
+		}
+		//reset FP timer
+		if (th.fp_time[i] > 0 && t > fp_delay) {
+			th.fp_time[i] = -1;
+			th.fp[i] = false;
+		}
 	}
 }
 
 void CEvaluation::process_reference(scgms::UDevice_Event& event)
 {
-	//not detected
-	if (data.ref_time > 0 && !data.bDetected) {
-		data.day.FN++;
-	}
+	EvalThresholds& th = data.th;
 
-	//set new reference
-	data.day.count++;
-	data.ref_time = event.device_time();
-	data.bDetected = false;
-	data.bConfirmed = false;
+	for (size_t i = 0; i < th.size(); ++i) {
+		//not detected
+		if (data.ref_time > 0 && !th.detected[i]) {
+			th.day[i].FN++;
+		}
+
+		//set new reference
+		th.day[i].count++;
+		th.detected[i] = false;
+		th.confirmed[i] = false;
 
-	//check detection beforehand
-	auto t = (event.device_time() - data.fp_time) / scgms::One_Minute;
-	if (!data.bFP && data.fp_time > 0 && t <= late_delay) {
-		data.bDetected = true;
-		data.day.TPd++;
-		data.detect_time = data.fp_time;
+		//check detection beforehand
+		auto t = (event.device_time() - th.fp_time[i]) / scgms::One_Minute;
+		if (!th.fp[i] && th.fp_time[i] > 0 && t <= late_delay) {
+			th.detected[i] = true;
+			th.day[i].TPd++;
+			th.detect_time[i] = th.fp_time[i];
+		}
 	}
+	data.ref_time = event.device_time();
 }
 
 void CEvaluation::process_detection(scgms::UDevice_Event& event)
 {
-	//detected
-	if (event.level() >= th_detection) {
-		//detected (increment TP only once)
-		if (data.ref_time > 0 && !data.bDetected) {
-			data.bDetected = true;
-			data.day.TPd++;
-			data.day.delay += event.device_time() - data.ref_time;
-			data.detect_time = event.device_time();
-		}
-	}
-	//confirmed
-	if (event.level() >= th_confirmation) {
-		if (data.ref_time > 0 && !data.bConfirmed) {
-			data.bConfirmed = true;
-			data.day.TPc++;
-			data.day.delay_conf += event.device_time() - data.detect_time;
+	EvalThresholds& th = data.th;
+	const double level = event.level();
+
+	for (size_t i = 0; i < th.size(); ++i) {
+		//detected
+		if (level >= th.detection[i]) {
+			//detected (increment TP only once)
+			if (data.ref_time > 0 && !th.detected[i]) {
+				th.detected[i] = true;
+				th.day[i].TPd++;
+				th.day[i].delay += event.device_time() - data.ref_time;
+				th.detect_time[i] = event.device_time();
+			}
 		}
-		//false detection (or late)
-		if (data.ref_time == -1 && data.fp_time == -1) {
-			data.fp_time = event.device_time();
-			//data.day.FPc++;
+		//confirmed
+		if (level >= th.confirmation[i]) {
+			if (data.ref_time > 0 && !th.confirmed[i]) {
+				th.confirmed[i] = true;
+				th.day[i].TPc++;
+				th.day[i].delay_conf += event.device_time() - th.detect_time[i];
+			}
+			//false detection (or late)
+			if (data.ref_time == -1 && th.fp_time[i] == -1) {
+				th.fp_time[i] = event.device_time();
+			}
 		}
 	}
 }
 
+namespace {
+	void write_statistics(detection::CState_Snapshot& state, const StatisticsData& s) {
+		state.write(static_cast<uint64_t>(s.count));
+		state.write(static_cast<uint64_t>(s.TPd));
+		state.write(static_cast<uint64_t>(s.TPc));
+		state.write(static_cast<uint64_t>(s.FN));
+		state.write(static_cast<uint64_t>(s.FPd));
+		state.write(static_cast<uint64_t>(s.FPc));
+		state.write(s.delay);
+		state.write(s.delay_conf);
+	}
+
+	void read_statistics(detection::CState_Snapshot& state, StatisticsData& s) {
+		s.count = static_cast<size_t>(state.read_uint());
+		s.TPd = static_cast<size_t>(state.read_uint());
+		s.TPc = static_cast<size_t>(state.read_uint());
+		s.FN = static_cast<size_t>(state.read_uint());
+		s.FPd = static_cast<size_t>(state.read_uint());
+		s.FPc = static_cast<size_t>(state.read_uint());
+		s.delay = state.read_double();
+		s.delay_conf = state.read_double();
+	}
+}
+
+bool CEvaluation::save_state() const
+{
+	detection::CState_Snapshot state(detection::id_eval);
+	state.write(static_cast<uint64_t>(data.th.size()));
+	for (size_t i = 0; i < data.th.size(); ++i) {
+		state.write(data.th.detection[i]);
+		state.write(data.th.confirmation[i]);
+	}
+	state.write(offline);
+
+	state.write(static_cast<uint64_t>(data.drop_count));
+	state.write(data.date);
+	state.write(data.ref_time);
+	for (size_t i = 0; i < data.th.size(); ++i) {
+		state.write(data.th.detect_time[i]);
+		state.write(data.th.fp_time[i]);
+		state.write(data.th.detected[i] != 0);
+		state.write(data.th.confirmed[i] != 0);
+		state.write(data.th.fp[i] != 0);
+		write_statistics(state, data.th.global[i]);
+		write_statistics(state, data.th.segment[i]);
+		write_statistics(state, data.th.day[i]);
+	}
+
+	state.write(static_cast<uint64_t>(segments.size()));
+	segments.for_each([&state](uint64_t seg_id, double last_time, const EvalSegmentIndex& segment) {
+		state.write(seg_id);
+		state.write(last_time);
+		state.write(segment.references);
+		state.write(segment.detection_times);
+		state.write(segment.detection_levels);
+	});
+
+	return state.save(snapshot.path());
+}
+
+void CEvaluation::restore_state()
+{
+	data = create_data();
+	segments.clear();
+
+	detection::CState_Snapshot state(detection::id_eval);
+	if (!snapshot.enabled() || !state.load(snapshot.path()) || state.read_uint() != data.th.size()) {
+		return;
+	}
+	for (size_t i = 0; i < data.th.size(); ++i) {
+		if (state.read_double() != data.th.detection[i] || state.read_double() != data.th.confirmation[i]) return;
+	}
+	if (state.read_bool() != offline) return;
+
+	EvalSegmentData restored = create_data();
+	restored.drop_count = static_cast<size_t>(state.read_uint());
+	restored.date = state.read_double();
+	restored.ref_time = state.read_double();
+	for (size_t i = 0; i < restored.th.size(); ++i) {
+		restored.th.detect_time[i] = state.read_double();
+		restored.th.fp_time[i] = state.read_double();
+		restored.th.detected[i] = state.read_bool();
+		restored.th.confirmed[i] = state.read_bool();
+		restored.th.fp[i] = state.read_bool();
+		read_statistics(state, restored.th.global[i]);
+		read_statistics(state, restored.th.segment[i]);
+		read_statistics(state, restored.th.day[i]);
+	}
+
+	const uint64_t count = state.read_uint();
+	for (uint64_t i = 0; i < count && state.good(); ++i) {
+		const uint64_t seg_id = state.read_uint();
+		const double last_time = state.read_double();
+		EvalSegmentIndex segment;
+		state.read(segment.references);
+		state.read(segment.detection_times);
+		state.read(segment.detection_levels);
+		if (segment.detection_times.size() != segment.detection_levels.size()) break;
+		segments.insert(seg_id, last_time, std::move(segment));
+	}
+
+	if (state.finished()) {
+		data = restored;
+	}
+	else {
+		segments.clear();
+	}
+}
+
 ::StatisticsData& StatisticsData::operator+=(const StatisticsData& day)
 {
 	count += day.count;
@@ -56,9 +56,15 @@
 #include <rtl/referencedImpl.h>
 #include <rtl/UILib.h>
 
+#include <map>
 #include <sstream>
+#include <vector>
 
 #include "swl.h"
+#include "segment_store.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "evaluation_output.h"
 
 
 #pragma warning( push )
@@ -79,20 +85,47 @@ struct StatisticsData
 	::StatisticsData& operator+=(const StatisticsData& day);
 };
 
+/*Matching state of the evaluated thresholds side by side, one array per field (structure of arrays)
+ * Threshold 0 is the default pair (detection 1, confirmation 2), the others are given by the threshold sweep,
+ * so the detected signal is read once for all points of the ROC curve.
+ */
+struct EvalThresholds {
+	std::vector<double> detection;
+	std::vector<double> confirmation;
+
+	std::vector<double> detect_time;
+	std::vector<double> fp_time;
+	std::vector<uint8_t> detected;
+	std::vector<uint8_t> confirmed;
+	std::vector<uint8_t> fp;
+
+	std::vector<StatisticsData> global;
+	//totals of the days closed since the last segment stop
+	std::vector<StatisticsData> segment;
+	std::vector<StatisticsData> day;
+
+	size_t size() const { return detection.size(); }
+	void add(double th_detection, double th_confirmation);
+};
+
 struct EvalSegmentData {
 	size_t drop_count = 0;
 
 	double date = 0;
+	//reference time is common to all thresholds
 	double ref_time = -1;
-	double detect_time = 0;
-	double fp_time = -1;
-	
-	bool bDetected = false;
-	bool bConfirmed = false;
-	bool bFP = false;
 
-	StatisticsData global;
-	StatisticsData day;
+	EvalThresholds th;
+};
+
+/*Reference and detection events of a segment for the offline matching, arrays sorted by device time*/
+struct EvalSegmentIndex {
+	std::vector<double> references;
+	std::vector<double> detection_times;
+	std::vector<double> detection_levels;
+
+	/*Events come in the device time order, the arrays are sorted only if they do not*/
+	void sort();
 };
 
 class CEvaluation : public scgms::CBase_Filter {
@@ -106,6 +139,9 @@ public:
 
 	virtual HRESULT IfaceCalling QueryInterface(const GUID* riid, void** ppvObj) override final;
 
+	/*Statistics rows written to the output file so far, see detection::CEvaluation_Output::read*/
+	std::vector<detection::CEvaluation_Output::TRow> statistics_rows() const { return output.read(); }
+
 private:
 	GUID signal_ref = Invalid_GUID;
 	GUID signal_det = Invalid_GUID;
@@ -116,10 +152,49 @@ private:
 	size_t min_ref = 0;
 	size_t th_detection = 1;
 	size_t th_confirmation = 2;
+	//additional (detection, confirmation) thresholds evaluated in the same pass
+	std::vector<std::pair<double, double>> sweep;
 
 	EvalSegmentData data;
-
-	/*Process timed operations - late detection, reset timers*/
+	/*Offline matching indexes the events of each segment and matches them at the segment stop*/
+	bool offline = false;
+	segment_store<EvalSegmentIndex> segments;
+	/*Empty state with all evaluated thresholds*/
+	EvalSegmentData create_data() const;
+	/*Statistics of all thresholds as a table, one row per threshold*/
+	std::wstring sweep_table() const;
+
+	/*Per-day and per-segment statistics rows of all thresholds (CSV or binary dataset)*/
+	detection::CEvaluation_Output output;
+	/*Write the statistics of all thresholds as rows of the given kind and flush them, E_FAIL if the rows cannot be written*/
+	HRESULT write_rows(detection::CEvaluation_Output::NKind kind, uint64_t segment_id, double time, const std::vector<StatisticsData>& statistics);
+
+	detection::CFilter_Metrics metrics{ L"Evaluation" };
+
+	/*Snapshot keeps the statistics and the skipped events over restarts*/
+	detection::CSnapshot_Schedule snapshot;
+	/*Write the state to the snapshot file*/
+	bool save_state() const;
+	/*Restore the state from the snapshot file, cold start if the snapshot is missing or invalid*/
+	void restore_state();
+
+	/*Send the info with the global statistics (and the sweep table)*/
+	HRESULT send_statistics(uint64_t segment_id, double device_time);
+
+	/*Offline matching - add the reference or detection to the index of its segment, match the segment at its stop*/
+	HRESULT index_event(scgms::UDevice_Event& event);
+	/*Offline matching - match the indexed segment for all thresholds, add it to the global statistics and send them*/
+	HRESULT evaluate_segment(uint64_t segment_id, double device_time);
+	/*Interval sweep of one threshold over the indexed segment, statistics by date
+	 * Every reference has its own window [ref - late_delay, ref + max_delay], so overlapping meals are matched
+	 * independently, detections outside of all windows are FP (one per fp_delay cooldown).
+	 */
+	void match_segment(const EvalSegmentIndex& segment, size_t threshold, std::map<double, std::vector<StatisticsData>>& days) const;
+
+	/*Add the current day to the segment and global statistics (days with enough references only) and start a new one*/
+	void close_day();
+
+	/*Process timed operations of all thresholds - late detection, reset timers*/
 	void process_signal(scgms::UDevice_Event& event);
 	/*Process reference signal - FP if not detected, set new reference time*/
 	void process_reference(scgms::UDevice_Event& event);
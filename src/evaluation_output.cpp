@@ -0,0 +1,189 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#include "evaluation_output.h"
+#include "evaluation.h"
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace detection {
+
+	void CEvaluation_Output::open(const std::filesystem::path& path) {
+		close();
+		this->path = path;
+
+		if (path.extension() == ".csv") {
+			const bool empty = !std::filesystem::exists(path) || std::filesystem::file_size(path) == 0;
+			csv.clear();
+			csv.open(path, std::ios::app);
+			if (!csv.is_open()) {
+				throw std::runtime_error("error while opening file " + path.string());
+			}
+			//times and delays are read back exactly
+			csv << std::setprecision(std::numeric_limits<double>::max_digits10);
+			if (empty) {
+				csv << "kind,segment_id,time,threshold,detection,confirmation,ref_count,tp_detected,tp_confirmed,fn,fp_detected,fp_confirmed,delay,confirmation_delay\n";
+			}
+		}
+		else {
+			binary = std::make_unique<dataset_writer>(path.string(), Column_Count, true, Block_Rows);
+		}
+	}
+
+	void CEvaluation_Output::write(NKind kind, uint64_t segment_id, double time, size_t threshold, double detection, double confirmation, const StatisticsData& statistics) {
+		const double delay = statistics.delay / scgms::One_Minute;
+		const double delay_conf = statistics.delay_conf / scgms::One_Minute;
+
+		if (csv.is_open()) {
+			csv << (kind == NKind::Day ? "day" : "segment") << ',' << segment_id << ',' << time << ',' << threshold << ',' << detection << ',' << confirmation << ','
+				<< statistics.count << ',' << statistics.TPd << ',' << statistics.TPc << ',' << statistics.FN << ',' << statistics.FPd << ',' << statistics.FPc << ','
+				<< delay << ',' << delay_conf << '\n';
+		}
+		else if (binary) {
+			std::vector<double> row(Column_Count);
+			row[Segment_Id] = static_cast<double>(segment_id);
+			row[Time] = time;
+			row[Threshold] = static_cast<double>(threshold);
+			row[Detection] = detection;
+			row[Confirmation] = confirmation;
+			row[Ref_Count] = static_cast<double>(statistics.count);
+			row[TP_Detected] = static_cast<double>(statistics.TPd);
+			row[TP_Confirmed] = static_cast<double>(statistics.TPc);
+			row[FN] = static_cast<double>(statistics.FN);
+			row[FP_Detected] = static_cast<double>(statistics.FPd);
+			row[FP_Confirmed] = static_cast<double>(statistics.FPc);
+			row[Delay] = delay;
+			row[Confirmation_Delay] = delay_conf;
+			binary->push_back(row, static_cast<uint64_t>(kind));
+		}
+	}
+
+	void CEvaluation_Output::flush() {
+		if (csv.is_open()) {
+			csv.flush();
+			if (csv.fail()) {
+				throw std::runtime_error("error while writing the evaluation output");
+			}
+		}
+		if (binary) {
+			binary->flush();
+		}
+	}
+
+	void CEvaluation_Output::close() {
+		if (csv.is_open()) {
+			csv.close();
+			if (csv.fail()) {
+				throw std::runtime_error("error while writing the evaluation output");
+			}
+		}
+		if (binary) {
+			auto writer = std::move(binary);
+			writer->close();
+		}
+	}
+
+	std::vector<CEvaluation_Output::TRow> CEvaluation_Output::read() const {
+		std::vector<TRow> rows;
+		if (path.empty()) {
+			return rows;
+		}
+
+		if (path.extension() == ".csv") {
+			std::ifstream f(path);
+			if (!f.is_open()) {
+				throw std::runtime_error("error while opening file " + path.string());
+			}
+
+			std::string line;
+			std::getline(f, line);	//header
+			while (std::getline(f, line)) {
+				if (line.empty()) continue;
+
+				std::stringstream fields(line);
+				std::string field;
+				std::getline(fields, field, ',');
+				TRow row{ field == "day" ? NKind::Day : NKind::Segment, {} };
+				size_t j = 0;
+				for (; j < Column_Count && std::getline(fields, field, ','); ++j) {
+					try {
+						row.values[j] = std::stod(field);
+					}
+					catch (const std::exception&) {
+						throw std::runtime_error("invalid row of the evaluation output: " + line);
+					}
+				}
+				if (j != Column_Count) {
+					throw std::runtime_error("invalid row of the evaluation output: " + line);
+				}
+				rows.push_back(row);
+			}
+			return rows;
+		}
+
+		const dataset_view view(path.string());
+		rows.reserve(view.rows());
+		for (size_t i = 0; i < view.rows(); ++i) {
+			TRow row{ static_cast<NKind>(view.label(i)), {} };
+			for (size_t j = 0; j < Column_Count; ++j) {
+				row.values[j] = view.value(i, j);
+			}
+			rows.push_back(row);
+		}
+		return rows;
+	}
+}
@@ -0,0 +1,111 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "ML/dataset.h"
+
+struct StatisticsData;
+
+namespace detection {
+
+	/*Machine-readable rows of the evaluation statistics
+	 * CSV (path with .csv extension) is appended line by line, the header is written to a new file only. Any other path
+	 * gets the binary columnar dataset (ML/dataset.h) appended by the streaming writer, the columns are given by NColumn
+	 * and the label is the kind of the row, so the file is read by dataset_view. Both formats are flushed after
+	 * each batch of rows, so the file holds all rows written so far, including those of previous runs.
+	 * Delays are in minutes as sums over the row (divide by TP detected or TP confirmed for the mean).
+	 */
+	class CEvaluation_Output {
+	public:
+		enum class NKind : uint64_t { Day = 0, Segment = 1 };
+		enum NColumn : size_t { Segment_Id, Time, Threshold, Detection, Confirmation, Ref_Count, TP_Detected, TP_Confirmed, FN, FP_Detected, FP_Confirmed, Delay, Confirmation_Delay, Column_Count };
+
+		struct TRow {
+			NKind kind;
+			std::array<double, Column_Count> values;
+		};
+
+		/*Opens the output, throws std::runtime_error if the file cannot be opened*/
+		void open(const std::filesystem::path& path);
+		bool is_open() const { return csv.is_open() || binary != nullptr; }
+
+		/*Row of one threshold (index and values) of the segment, time is the day or the segment stop*/
+		void write(NKind kind, uint64_t segment_id, double time, size_t threshold, double detection, double confirmation, const StatisticsData& statistics);
+
+		/*Writes the buffered rows to the file, throws std::runtime_error on failure*/
+		void flush();
+
+		/*Flushes and closes the file, throws std::runtime_error on failure*/
+		void close();
+
+		/*Rows of the file written so far (also after close), empty if no file was opened
+		 * Throws std::runtime_error or std::invalid_argument if the file cannot be read.
+		 */
+		std::vector<TRow> read() const;
+
+	private:
+		/*Few rows are written per batch and the open block is rewritten padded on every flush, so the blocks are small*/
+		static constexpr size_t Block_Rows = 16;
+
+		std::filesystem::path path;
+		std::ofstream csv;
+		std::unique_ptr<dataset_writer> binary;
+	};
+}
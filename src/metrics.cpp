@@ -0,0 +1,363 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <mutex>
+#include <sstream>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+	std::mutex registry_mutex;
+	std::vector<const detection::CFilter_Metrics*> registry;
+
+	//time and allocations of the downstream filters of the current Do_Execute call
+	thread_local uint64_t child_time = 0;
+	thread_local uint64_t child_allocations = 0;
+
+	//heap allocations of the thread
+	thread_local uint64_t thread_allocations = 0;
+
+	//start of send() for the called filter and the end of the called filter for send(), 0 = not set
+	thread_local uint64_t send_start = 0;
+	thread_local uint64_t send_end = 0;
+
+	//total of all calls estimated from the total of the timed calls
+	uint64_t estimate(uint64_t timed_total, uint64_t calls, uint64_t timed_calls) {
+		return timed_calls ? static_cast<uint64_t>(static_cast<double>(timed_total) * calls / timed_calls + 0.5) : 0;
+	}
+
+	size_t highest_bit(uint64_t value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+}
+
+#ifdef DETECTION_COUNT_ALLOCATIONS
+void* operator new(std::size_t size) {
+	thread_allocations++;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+#endif
+
+namespace detection {
+
+	std::atomic<bool> CFilter_Metrics::enabled{ true };
+	std::atomic<uint32_t> CFilter_Metrics::sample_period{ 256 };
+	thread_local bool CFilter_Metrics::thread_timed = false;
+
+	const wchar_t* stage_name(NStage stage) {
+		switch (stage) {
+		case NStage::Smoothing: return L"smoothing";
+		case NStage::Activation: return L"activation";
+		case NStage::RNN: return L"rnn";
+		case NStage::Features: return L"features";
+		case NStage::Classification: return L"classification";
+		default: return L"";
+		}
+	}
+
+	uint64_t CFilter_Metrics::now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void CFilter_Metrics::next_sample() {
+		//random gaps with the mean of sample_period, so the timed calls do not follow a period of the input
+		sample_state ^= sample_state << 13;
+		sample_state ^= sample_state >> 7;
+		sample_state ^= sample_state << 17;
+		const uint64_t period = std::max<uint32_t>(sample_period.load(std::memory_order_relaxed), 1);
+		sample_countdown = 1 + sample_state % (2 * period - 1);
+	}
+
+	uint64_t CFilter_Metrics::begin_send() {
+		send_start = now();
+		send_end = 0;
+		return send_start;
+	}
+
+	uint64_t CFilter_Metrics::end_send() {
+		//the filter after the send is not measured, so its time is read here
+		const uint64_t end = send_end ? send_end : now();
+		send_start = 0;
+		send_end = 0;
+		return end;
+	}
+
+	uint64_t CFilter_Metrics::allocation_count() {
+		return thread_allocations;
+	}
+
+	void CFilter_Metrics::add_child(uint64_t time, uint64_t allocations) {
+		child_time += time;
+		child_allocations += allocations;
+	}
+
+	size_t CLatency_Histogram::index(uint64_t value) {
+		if (value < sub_count) return static_cast<size_t>(value);
+
+		const size_t msb = highest_bit(value);
+		return (msb - sub_bits + 1) * sub_count + static_cast<size_t>((value >> (msb - sub_bits)) & (sub_count - 1));
+	}
+
+	uint64_t CLatency_Histogram::lower_bound(size_t index) {
+		if (index < sub_count) return index;
+
+		const size_t msb = index / sub_count + sub_bits - 1;
+		return (sub_count + index % sub_count) << (msb - sub_bits);
+	}
+
+	void CLatency_Histogram::add(uint64_t value) {
+		auto& bucket = counts[index(value)];
+		bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		if (value > maximum.load(std::memory_order_relaxed)) maximum.store(value, std::memory_order_relaxed);
+	}
+
+	double CLatency_Histogram::mean() const {
+		const uint64_t n = count();
+		return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+	}
+
+	uint64_t CLatency_Histogram::percentile(double p) const {
+		const uint64_t n = count();
+		if (n == 0) return 0;
+
+		const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * n + 0.5));
+		uint64_t cumulative = 0;
+		for (size_t i = 0; i < bucket_count; ++i) {
+			cumulative += counts[i].load(std::memory_order_relaxed);
+			if (cumulative >= rank) {
+				//middle of the bucket
+				const uint64_t low = lower_bound(i);
+				const uint64_t high = i + 1 < bucket_count ? lower_bound(i + 1) : low;
+				return std::min(low + (high - low) / 2, max());
+			}
+		}
+		return max();
+	}
+
+	void CFilter_Metrics::CScope::begin() {
+		saved_timed = thread_timed;
+		thread_timed = true;
+		start = send_start ? send_start : now();
+		send_start = 0;
+		start_allocations = thread_allocations;
+		saved_child = child_time;
+		saved_child_allocations = child_allocations;
+		child_time = 0;
+		child_allocations = 0;
+	}
+
+	CFilter_Metrics::CScope::CScope(CScope&& other) noexcept : metrics(other.metrics), suspended(other.suspended), saved_timed(other.saved_timed), start(other.start), saved_child(other.saved_child),
+		start_allocations(other.start_allocations), saved_child_allocations(other.saved_child_allocations) {
+		other.metrics = nullptr;
+		other.suspended = false;
+	}
+
+	void CFilter_Metrics::CScope::end() {
+		const uint64_t allocated = thread_allocations - start_allocations;
+		inc(metrics->allocations, allocated > child_allocations ? allocated - child_allocations : 0);
+
+		const uint64_t end = now();
+		const uint64_t elapsed = end - start;
+		metrics->latency.add(elapsed > child_time ? elapsed - child_time : 0);
+
+		//the whole call is already counted by send() of the calling filter
+		child_time = saved_child;
+		child_allocations = saved_child_allocations;
+		send_end = end;
+		thread_timed = saved_timed;
+	}
+
+	void CFilter_Metrics::CScope::suspend_timing() {
+		//the send of the calling filter is timed with its own clock reads
+		thread_timed = false;
+		send_start = 0;
+	}
+
+	void CFilter_Metrics::CScope::resume_timing() {
+		thread_timed = true;
+		send_end = 0;
+	}
+
+	void CFilter_Metrics::CStage_Scope::begin() {
+		timed = true;
+		start = now();
+		start_allocations = thread_allocations;
+	}
+
+	CFilter_Metrics::CStage_Scope::CStage_Scope(CStage_Scope&& other) noexcept : metrics(other.metrics), stage(other.stage), timed(other.timed), start(other.start), start_allocations(other.start_allocations) {
+		other.metrics = nullptr;
+	}
+
+	void CFilter_Metrics::CStage_Scope::end() {
+		const size_t i = static_cast<size_t>(stage);
+		metrics->stage_latency[i].add(now() - start);
+		inc(metrics->stage_allocations[i], thread_allocations - start_allocations);
+	}
+
+	CFilter_Metrics::CFilter_Metrics(const wchar_t* filter) : filter(filter) {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		registry.push_back(this);
+	}
+
+	CFilter_Metrics::~CFilter_Metrics() {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+	}
+
+	void CFilter_Metrics::state(size_t segments, size_t bytes, uint64_t evicted) {
+		segment_count.store(segments, std::memory_order_relaxed);
+		state_bytes.store(bytes, std::memory_order_relaxed);
+		evicted_count.store(evicted, std::memory_order_relaxed);
+	}
+
+	bool CFilter_Metrics::report_due(double device_time) {
+		if (report_period <= 0) return false;
+
+		if (last_report < 0) {
+			last_report = device_time;
+			return false;
+		}
+		if (device_time - last_report < report_period) return false;
+
+		last_report = device_time;
+		return true;
+	}
+
+	scgms::UDevice_Event CFilter_Metrics::report(const GUID& device_id, const scgms::UDevice_Event& event) const {
+		const auto s = snapshot();
+
+		scgms::UDevice_Event e(scgms::NDevice_Event_Code::Information);
+		e.device_id() = device_id;
+		e.signal_id() = Invalid_GUID;
+		e.segment_id() = event.segment_id();
+		e.device_time() = event.device_time();
+
+		std::wstringstream stream;
+		stream << L"Metrics " << s.filter << L": events: " << s.events << L", levels: " << s.levels << L", emitted: " << s.emitted
+			<< L", mean: " << s.mean / 1000.0 << L" us, p50: " << s.p50 / 1000.0 << L" us, p99: " << s.p99 / 1000.0 << L" us, max: " << s.max / 1000.0
+			<< L" us, segments: " << s.segments << L", state: " << s.state_bytes / 1024 << L" kB, evicted: " << s.evicted;
+#ifdef DETECTION_COUNT_ALLOCATIONS
+		stream << L", allocations: " << s.allocations;
+#endif
+		for (size_t i = 0; i < stage_count; ++i) {
+			const auto& stage = s.stages[i];
+			if (stage.count == 0) continue;
+
+			stream << L", " << stage_name(static_cast<NStage>(i)) << L" mean: " << stage.mean / 1000.0 << L" us, p99: " << stage.p99 / 1000.0 << L" us";
+		}
+		e.info.set(stream.str().c_str());
+
+		return e;
+	}
+
+	TMetrics_Snapshot CFilter_Metrics::snapshot() const {
+		TMetrics_Snapshot s;
+		s.filter = filter;
+		s.events = event_count.load(std::memory_order_relaxed);
+		s.levels = level_count.load(std::memory_order_relaxed);
+		s.emitted = emitted_count.load(std::memory_order_relaxed);
+		s.segments = segment_count.load(std::memory_order_relaxed);
+		s.state_bytes = state_bytes.load(std::memory_order_relaxed);
+		s.evicted = evicted_count.load(std::memory_order_relaxed);
+		s.mean = latency.mean();
+		s.p50 = latency.percentile(50);
+		s.p90 = latency.percentile(90);
+		s.p99 = latency.percentile(99);
+		s.max = latency.max();
+		s.allocations = estimate(allocations.load(std::memory_order_relaxed), s.events, latency.count());
+		for (size_t i = 0; i < stage_count; ++i) {
+			auto& stage = s.stages[i];
+			stage.count = stage_calls[i].load(std::memory_order_relaxed);
+			stage.allocations = estimate(stage_allocations[i].load(std::memory_order_relaxed), stage.count, stage_latency[i].count());
+			stage.mean = stage_latency[i].mean();
+			stage.p50 = stage_latency[i].percentile(50);
+			stage.p99 = stage_latency[i].percentile(99);
+			stage.max = stage_latency[i].max();
+		}
+		return s;
+	}
+
+	std::vector<TMetrics_Snapshot> metrics_snapshot() {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+
+		std::vector<TMetrics_Snapshot> snapshots;
+		for (auto metrics : registry) {
+			snapshots.push_back(metrics->snapshot());
+		}
+		return snapshots;
+	}
+}
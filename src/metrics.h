@@ -0,0 +1,304 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace detection {
+
+	/*Latency histogram with logarithmic buckets split to 16 linear sub-buckets (HDR-style),
+	 * relative error of a value is below 1/16. Written by one thread, readable from any thread.
+	 */
+	class CLatency_Histogram {
+	public:
+		static constexpr size_t sub_bits = 4;
+		static constexpr size_t sub_count = size_t(1) << sub_bits;
+		static constexpr size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+		void add(uint64_t value);
+
+		uint64_t count() const { return total.load(std::memory_order_relaxed); }
+		uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+		double mean() const;
+		/*Value at the given percentile (0-100)*/
+		uint64_t percentile(double p) const;
+
+	private:
+		std::array<std::atomic<uint64_t>, bucket_count> counts{};
+		std::atomic<uint64_t> total{ 0 };
+		std::atomic<uint64_t> sum{ 0 };
+		std::atomic<uint64_t> maximum{ 0 };
+
+		static size_t index(uint64_t value);
+		static uint64_t lower_bound(size_t index);
+	};
+
+	/*Stages of the event processing measured separately within Do_Execute*/
+	enum class NStage : size_t {
+		Smoothing,
+		Activation,
+		RNN,
+		Features,
+		Classification,
+		Count
+	};
+
+	constexpr size_t stage_count = static_cast<size_t>(NStage::Count);
+
+	/*Name of the stage for the reports*/
+	const wchar_t* stage_name(NStage stage);
+
+	/*Latency of one stage, in ns*/
+	struct TStage_Snapshot {
+		//all calls, the latencies come from the timed ones and the allocations are estimated from them
+		uint64_t count = 0;
+		uint64_t allocations = 0;
+		double mean = 0;
+		uint64_t p50 = 0;
+		uint64_t p99 = 0;
+		uint64_t max = 0;
+	};
+
+	/*Metrics of one filter, latencies in ns*/
+	struct TMetrics_Snapshot {
+		std::wstring filter;
+		uint64_t events = 0;
+		uint64_t levels = 0;
+		uint64_t emitted = 0;
+		uint64_t segments = 0;
+		uint64_t state_bytes = 0;
+		uint64_t evicted = 0;
+		double mean = 0;
+		uint64_t p50 = 0;
+		uint64_t p90 = 0;
+		uint64_t p99 = 0;
+		uint64_t max = 0;
+		//heap allocations of Do_Execute without the downstream filters, estimated from the timed calls,
+		//counted only with DETECTION_COUNT_ALLOCATIONS
+		uint64_t allocations = 0;
+		std::array<TStage_Snapshot, stage_count> stages{};
+	};
+
+	/*Always-on instrumentation of a filter - self time of Do_Execute, latencies of its stages, event counters,
+	 * heap allocations and size of the segment state.
+	 * Counters are exact, the rest is measured only in the timed Do_Execute calls, randomly sampled by each filter
+	 * (one of sample_period on average), so the untimed calls read no clock. Allocations are estimated from the timed calls.
+	 * Events sent by send() are timed as the downstream time and excluded from the self time, so the self time
+	 * does not contain any following filter of the chain (measured or not). Events sent directly by mOutput.Send
+	 * are counted as the self time.
+	 * Allocations are counted by the replacement of the global operator new, which is compiled in only
+	 * with DETECTION_COUNT_ALLOCATIONS (the host must not replace it), otherwise they stay zero.
+	 */
+	class CFilter_Metrics {
+	public:
+		/*Measurement of one Do_Execute call*/
+		class CScope {
+		public:
+			/*Timed call of the metrics, or the untimed call which suspends the timing of the calling filter (suspend)*/
+			explicit CScope(CFilter_Metrics* metrics, bool suspend = false) : metrics(metrics), suspended(suspend) {
+				if (metrics) begin();
+				else if (suspended) suspend_timing();
+			}
+			CScope(CScope&& other) noexcept;
+			CScope(const CScope&) = delete;
+			~CScope() {
+				if (metrics) end();
+				else if (suspended) resume_timing();
+			}
+		private:
+			CFilter_Metrics* metrics;
+			bool suspended = false;
+			bool saved_timed = false;
+			uint64_t start = 0;
+			uint64_t saved_child = 0;
+			uint64_t start_allocations = 0;
+			uint64_t saved_child_allocations = 0;
+
+			void begin();
+			void end();
+			static void suspend_timing();
+			static void resume_timing();
+		};
+
+		/*Measurement of one stage, timed in the timed calls only, the stage must not send events (its time is the wall time)*/
+		class CStage_Scope {
+		public:
+			CStage_Scope(CFilter_Metrics* metrics, NStage stage) : metrics(metrics), stage(stage) { if (metrics && thread_timed) begin(); }
+			CStage_Scope(CStage_Scope&& other) noexcept;
+			CStage_Scope(const CStage_Scope&) = delete;
+			~CStage_Scope() {
+				if (!metrics) return;
+
+				inc(metrics->stage_calls[static_cast<size_t>(stage)]);
+				if (timed) end();
+			}
+		private:
+			CFilter_Metrics* metrics;
+			NStage stage;
+			bool timed = false;
+			uint64_t start = 0;
+			uint64_t start_allocations = 0;
+
+			void begin();
+			void end();
+		};
+
+		explicit CFilter_Metrics(const wchar_t* filter);
+		~CFilter_Metrics();
+		CFilter_Metrics(const CFilter_Metrics&) = delete;
+		CFilter_Metrics& operator=(const CFilter_Metrics&) = delete;
+
+		/*Global switch, used to measure the overhead of the instrumentation*/
+		static std::atomic<bool> enabled;
+		/*Mean number of Do_Execute calls per timed call, 1 = every call is timed*/
+		static std::atomic<uint32_t> sample_period;
+
+		CScope measure(const scgms::UDevice_Event& event) {
+			if (!enabled.load(std::memory_order_relaxed)) return CScope(nullptr);
+
+			inc(event_count);
+			if (event.is_level_event()) inc(level_count);
+
+			if (sample()) return CScope(this);
+			//untimed call made by a timed call must not add its sends to the time of the calling filter
+			return CScope(nullptr, thread_timed);
+		}
+
+		CStage_Scope stage(NStage stage) {
+			return CStage_Scope(enabled.load(std::memory_order_relaxed) ? this : nullptr, stage);
+		}
+
+		/*Sends the event to the output, the time of the downstream filters is excluded from the self time*/
+		template <class O>
+		HRESULT send(O& output, scgms::UDevice_Event& event) {
+			if (!thread_timed) return output.Send(event);
+
+			const uint64_t start = begin_send();
+			const uint64_t allocations = allocation_count();
+			const HRESULT rc = output.Send(event);
+			add_child(end_send() - start, allocation_count() - allocations);
+			return rc;
+		}
+
+		void emitted(uint64_t count = 1) { inc(emitted_count, count); }
+		/*Number of segments, approximate size of their state and total number of evicted segments*/
+		void state(size_t segments, size_t bytes, uint64_t evicted = 0);
+
+		/*Period of the Information events in device time, 0 = disabled*/
+		void set_period(double period) { report_period = period; last_report = -1; }
+		/*Checks the period of the Information event*/
+		bool report_due(double device_time);
+		/*Information event with the current metrics*/
+		scgms::UDevice_Event report(const GUID& device_id, const scgms::UDevice_Event& event) const;
+
+		TMetrics_Snapshot snapshot() const;
+
+	private:
+		std::wstring filter;
+		CLatency_Histogram latency;
+		std::array<CLatency_Histogram, stage_count> stage_latency;
+		std::array<std::atomic<uint64_t>, stage_count> stage_calls{};
+		//allocations of the timed calls
+		std::array<std::atomic<uint64_t>, stage_count> stage_allocations{};
+		std::atomic<uint64_t> allocations{ 0 };
+		std::atomic<uint64_t> event_count{ 0 };
+		std::atomic<uint64_t> level_count{ 0 };
+		std::atomic<uint64_t> emitted_count{ 0 };
+		std::atomic<uint64_t> segment_count{ 0 };
+		std::atomic<uint64_t> state_bytes{ 0 };
+		std::atomic<uint64_t> evicted_count{ 0 };
+
+		double report_period = 0;
+		double last_report = -1;
+
+		//calls left to the next timed call and the state of the generator of the random gaps
+		uint64_t sample_countdown = 1;
+		uint64_t sample_state = 0x9e3779b97f4a7c15ull;
+		/*Decides whether the Do_Execute call is timed*/
+		bool sample() {
+			if (--sample_countdown > 0) return false;
+
+			next_sample();
+			return true;
+		}
+		/*Draws the gap to the next timed call*/
+		void next_sample();
+
+		/*The current Do_Execute call of the thread is timed*/
+		static thread_local bool thread_timed;
+
+		static uint64_t now();
+		/*Start and end of send(), the measured filter called by the send takes the start as its own start
+		 * and hands its end back, so a hop between two measured filters reads the clock only twice
+		 */
+		static uint64_t begin_send();
+		static uint64_t end_send();
+		/*Allocations of the current thread*/
+		static uint64_t allocation_count();
+		/*Time and allocations of the downstream filters of the current Do_Execute call*/
+		static void add_child(uint64_t time, uint64_t allocations);
+
+		/*Single writer increment, no locked instruction is needed*/
+		static void inc(std::atomic<uint64_t>& value, uint64_t count = 1) {
+			value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+		}
+	};
+
+	/*Metrics of all existing filters*/
+	std::vector<TMetrics_Snapshot> metrics_snapshot();
+}
@@ -0,0 +1,96 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "twl.h"
+
+namespace detection {
+	class CState_Snapshot;
+}
+
+/*Decimation of a high-rate signal to bins of fixed duration with cascaded windows of coarser resolutions
+ * Samples are summed to the open bin, the bin is closed by the first sample after its end. A closed bin
+ * gives the mean and the energy (mean square) of its samples and is pushed to the window of every
+ * resolution, the windows keep the sums of the bin aggregates, so the aggregates of all resolutions
+ * are read in O(1) per bin instead of going over the raw samples.
+ */
+class multires
+{
+public:
+	/*Aggregate of a closed bin*/
+	struct bin {
+		double time = -1;	//end of the bin
+		double mean = 0;
+		double energy = 0;
+	};
+
+	multires() = default;
+	/*Bin length and resolutions (window lengths) in the device time*/
+	multires(double bin_length, const std::vector<double>& resolutions) : _bin_length(bin_length) {
+		for (double resolution : resolutions) {
+			_means.emplace_back(resolution);
+			_energies.emplace_back(resolution);
+		}
+	}
+
+	/*Adds the sample, returns true if the sample closed the previous bin (available by last())*/
+	bool push(double time, double value) {
+		bool closed = false;
+		if (_count > 0 && time >= _end) {
+			closed = close();
+		}
+		if (_count == 0) {
+			_end = (std::floor(time / _bin_length) + 1) * _bin_length;
+		}
+
+		_sum += value;
+		_sum_sq += value * value;
+		_count++;
+
+		return closed;
+	}
+
+	/*Closes the open bin, returns false if the bin is empty*/
+	bool close() {
+		if (_count == 0) return false;
+
+		_last = { _end, _sum / _count, _sum_sq / _count };
+		for (size_t i = 0; i < _means.size(); ++i) {
+			_means[i].push_back(_last.time, _last.mean);
+			_energies[i].push_back(_last.time, _last.energy);
+		}
+
+		_sum = 0;
+		_sum_sq = 0;
+		_count = 0;
+		return true;
+	}
+
+	const bin& last() const { return _last; }
+
+	size_t resolutions() const { return _means.size(); }
+	/*Mean of the bin means within the resolution*/
+	double mean(size_t resolution) const { return _means[resolution].mean(); }
+	/*Mean energy of the bins within the resolution, its square root is the RMS of the samples*/
+	double energy(size_t resolution) const { return _energies[resolution].mean(); }
+
+private:
+	friend class detection::CState_Snapshot;
+
+	double _bin_length = 0;
+
+	//open bin
+	double _end = -1;
+	double _sum = 0;
+	double _sum_sq = 0;
+	size_t _count = 0;
+
+	bin _last;
+	std::vector<twl<double>> _means;
+	std::vector<twl<double>> _energies;
+};
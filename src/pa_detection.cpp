@@ -51,6 +51,7 @@
   */
 
 #include "pa_detection.h"
+#include "trace.h"
 
 CPa_Detection::CPa_Detection(scgms::IFilter* output) : CBase_Filter(output) {
 	//
@@ -91,7 +92,49 @@ HRESULT IfaceCalling CPa_Detection::Do_Configure(scgms::SFilter_Configuration co
 		th_signal.emplace(scgms::signal_Electrodermal_Activity, def[3]);
 	}
 
-	if (b_mean = configuration.Read_Bool(detection::rsMean) || b_class) {
+	b_class = configuration.Read_Bool(detection::rsClass);
+	b_online = configuration.Read_Bool(detection::rsOnline);
+	if (b_class) {
+		class_path = configuration.Read_File_Path(detection::rsClassData);
+		class_model = configuration.Read_File_Path(detection::rsClassModel);
+		if (!std::filesystem::is_regular_file(class_model) && !std::filesystem::is_regular_file(class_path)) {
+			error_description.push(L"Classifier model or training data file doesn't exists!");
+			return E_INVALIDARG;
+		}
+
+		//l - logistic regression, b - naive Bayes, empty - type of the binary model file or the default
+		const std::wstring type = configuration.Read_String(detection::rsClassType);
+		const char model_type = std::filesystem::is_regular_file(class_model) ? ml::model_type(class_model) : 0;
+		if (type == L"l" || type == L"b") {
+			class_type = static_cast<char>(type[0]);
+		}
+		else if (!type.empty()) {
+			error_description.push(L"Classifier type must be l (logistic regression) or b (naive Bayes)!");
+			return E_INVALIDARG;
+		}
+		else if (model_type != 0) {
+			class_type = model_type;
+		}
+		else {
+			class_type = b_online ? 'b' : 'l';
+		}
+	}
+
+	label_signal = configuration.Read_GUID(detection::rsLabelSignal, scgms::signal_Physical_Activity);
+
+	auto ttl = configuration.Read_Int(detection::rsSegmentTTL, 0);
+	auto max_segments = configuration.Read_Int(detection::rsMaxSegments, 0);
+	if (ttl < 0 || max_segments < 0) {
+		error_description.push(L"Segment TTL and max segments must be non-negative!");
+		return E_INVALIDARG;
+	}
+	mSegments.set_limits(ttl * scgms::One_Minute, static_cast<size_t>(max_segments));
+
+	metrics.set_period(configuration.Read_Int(detection::rsMetricsPeriod, 0) * scgms::One_Minute);
+
+	//classifier features include the mean
+	b_mean = configuration.Read_Bool(detection::rsMean) || b_class || b_online;
+	if (b_mean) {
 		mean_window = configuration.Read_Int(detection::rsMeanSize);
 		if (mean_window < 1) {
 			error_description.push(L"Window size must be at least 1!");
@@ -102,6 +145,68 @@ HRESULT IfaceCalling CPa_Detection::Do_Configure(scgms::SFilter_Configuration co
 		mean_window = 1;
 	}
 
+	mean_duration = configuration.Read_Int(detection::rsMeanDuration, 0) * scgms::One_Minute;
+	if (mean_duration < 0) {
+		error_description.push(L"Window length must be non-negative!");
+		return E_INVALIDARG;
+	}
+	if (!b_mean) {
+		mean_duration = 0;
+	}
+
+	align_bin = configuration.Read_Int(detection::rsAlignBin, 0) * scgms::One_Second;
+	if (align_bin < 0) {
+		error_description.push(L"Alignment bin must be non-negative!");
+		return E_INVALIDARG;
+	}
+	align_mean = configuration.Read_Bool(detection::rsAlignMean);
+
+	//decimation of the acceleration with resolutions in minutes separated by ';'
+	acc_bin = configuration.Read_Int(detection::rsAccBin, 0) * scgms::One_Second;
+	acc_resolutions.clear();
+	if (acc_bin > 0) {
+		std::wstringstream resolutions(configuration.Read_String(detection::rsAccResolutions));
+		std::wstring resolution;
+		while (std::getline(resolutions, resolution, L';')) {
+			if (resolution.find_first_not_of(L" \t") == std::wstring::npos) continue;
+
+			double minutes = 0;
+			try {
+				minutes = std::stod(resolution);
+			}
+			catch (const std::exception&) {
+				minutes = 0;
+			}
+			if (minutes * scgms::One_Minute < acc_bin) {
+				error_description.push(L"Cannot read the acceleration resolutions!");
+				return E_INVALIDARG;
+			}
+			acc_resolutions.push_back(minutes * scgms::One_Minute);
+		}
+	}
+	else if (acc_bin < 0) {
+		error_description.push(L"Acceleration bin must be non-negative!");
+		return E_INVALIDARG;
+	}
+
+	const double heartbeat = configuration.Read_Int(detection::rsOutputHeartbeat, 0) * scgms::One_Minute;
+	if (!activation_output.configure(configuration.Read_String(detection::rsActivationOutput), heartbeat)
+		|| !detection_output.configure(configuration.Read_String(detection::rsDetectionOutput), heartbeat)) {
+		error_description.push(L"Output policy must be all, change or nonzero with non-negative heartbeat!");
+		return E_INVALIDARG;
+	}
+
+	auto export_path = configuration.Read_File_Path(detection::rsExportPath);
+	if (!export_path.empty() && !std::filesystem::is_directory(export_path)) {
+		try {
+			features_export = std::make_unique<dataset_writer>(export_path.string(), feature_count());
+		}
+		catch (const std::exception&) {
+			error_description.push(L"Cannot open the feature export file!");
+			return E_INVALIDARG;
+		}
+	}
+
 	if (configuration.Read_Bool(detection::rsDesc)) {
 		ist_signal = configuration.Read_GUID(detection::rsSignal, detection::signal_savgol);
 		ist_window = configuration.Read_Int(detection::rsWindowSize);
@@ -117,105 +222,448 @@ HRESULT IfaceCalling CPa_Detection::Do_Configure(scgms::SFilter_Configuration co
 	}
 
 	//classification - test purposes only
+	if (b_online && b_class && class_type != 'b') {
+		error_description.push(L"Online learning is supported only by naive Bayes classifier!");
+		return E_INVALIDARG;
+	}
+
 	if (b_class) {
-		classifier = std::make_unique<ml>(class_type, signals.size(), class_path);
+		auto load_error = [&error_description](const std::string& cause) {
+			const std::wstring message = L"Cannot load the classifier: " + std::wstring(cause.begin(), cause.end());
+			error_description.push(message.c_str());
+			return E_INVALIDARG;
+		};
+
+		try {
+			//trained model has priority over the training data
+			if (std::filesystem::is_regular_file(class_model)) {
+				classifier = std::make_unique<ml>(class_type, class_model);
+			}
+			else {
+				classifier = std::make_unique<ml>(class_type, signals.size(), class_path.string());
+			}
+		}
+		catch (const std::exception& e) {
+			return load_error(e.what());
+		}
+		//sklearn models throw messages
+		catch (const char* e) {
+			return load_error(e);
+		}
+		catch (...) {
+			error_description.push(L"Cannot load the classifier!");
+			return E_INVALIDARG;
+		}
+
+		//trained mean and variance would be replaced by the first sample of the label
+		if (b_online && !classifier->can_partial_fit()) {
+			error_description.push(L"Online learning needs the sample counts of the naive Bayes model, retrain the model!");
+			return E_INVALIDARG;
+		}
+
+		//the features of the model must match the configured signals and acceleration resolutions
+		const size_t features = classifier->feature_count();
+		if (features != 0 && features != feature_count()) {
+			const std::wstring message = L"The classifier expects " + std::to_wstring(features) + L" features, the configuration gives " + std::to_wstring(feature_count()) + L"!";
+			error_description.push(message.c_str());
+			return E_INVALIDARG;
+		}
+	}
+	else if (b_online) {
+		classifier = std::make_unique<ml>('b');
 	}
+
+	auto snapshot_path = configuration.Read_File_Path(detection::rsSnapshotPath);
+	if (std::filesystem::is_directory(snapshot_path)) snapshot_path.clear();
+	snapshot.configure(snapshot_path, configuration.Read_Int(detection::rsSnapshotPeriod, 0) * scgms::One_Minute);
+	restore_state();
 	
 	return S_OK;
 }
 
 HRESULT IfaceCalling CPa_Detection::Do_Execute(scgms::UDevice_Event event) {
+	auto scope = metrics.measure(event);
+
+	if (mSegments.evict(event.device_time()) > 0) {
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+	}
+
+	if (metrics.report_due(event.device_time())) {
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+		auto report = metrics.report(detection::id_pa, event);
+		auto rc = metrics.send(mOutput, report);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	if (snapshot.due(event) && !save_state()) {
+		auto warning = detection::snapshot_warning(detection::id_pa, event);
+		auto rc = metrics.send(mOutput, warning);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
 	if (event.is_level_event()) {
 		//get segment data
 		auto seg_id = event.segment_id();
-		auto it = mSegments.find(seg_id);
-		if (it == mSegments.end()) {
-			std::map<GUID, swl<double>> values;
-			std::map<GUID, SFeatures> features;
-			for each (GUID s in signals)
-			{
-				values.emplace(s, swl<double>(mean_window));
-				features.emplace(s, SFeatures());
-			}
-			swl<double> act(ist_window);
-			act.push_front(0);
+		PASegmentData* data = &mSegments.get(seg_id, event.device_time(), [this]() { return create_segment(); });
 
-			PASegmentData tmp = { -1, false, -1, -1, act, values, features };
-			it = mSegments.emplace(seg_id, tmp).first;
+		//confirmed activity label - update classifier of the segment
+		if (event.signal_id() == label_signal) {
+			data->label = event.level();
+		}
+		if (b_online && event.signal_id() == label_signal && data->last_event_time != -1) {
+			if (!data->classifier) {
+				data->classifier = std::make_shared<ml>(*classifier);
+			}
+			data->classifier->partial_fit(get_feature_vector(*data), event.level() > 0 ? 1 : 0);
 		}
-		PASegmentData* data = &it->second;
-
-		//detected pa event
-		scgms::UDevice_Event event_pa(scgms::NDevice_Event_Code::Level);
-		event_pa.device_id() = detection::id_pa;
-		event_pa.segment_id() = event.segment_id();
-		event_pa.device_time() = event.device_time();
-		event_pa.signal_id() = detection::signal_pa;
-		event_pa.level() = 0;
 
 		//ist signal
 		if (b_edge && event.signal_id() == detection::signal_savgol && event.level() > 0) {
-			double act = activation(event, *data);
+			double act = 0;
+			{
+				auto stage = metrics.stage(detection::NStage::Activation);
+				act = activation(event, *data) + 20;
+			}
 
 			//activation event
-			scgms::UDevice_Event event_act(scgms::NDevice_Event_Code::Level);
-			event_act.device_id() = detection::id_cho;
-			event_act.signal_id() = detection::signal_activation;
-			event_act.segment_id() = event.segment_id();
-			event_act.device_time() = event.device_time();
-			event_act.level() = act + 20;
-			auto rc = mOutput.Send(event_act);
-			if (!Succeeded(rc)) {
-				return rc;
+			if (activation_output.emit(data->emitted_activation, event.device_time(), act)) {
+				auto event_act = detection::level_event(detection::id_cho, detection::signal_activation, event.segment_id(), event.device_time(), act);
+				metrics.emitted();
+				auto rc = metrics.send(mOutput, event_act);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
 			}
 		}
 
 		if (std::find(signals.begin(), signals.end(), event.signal_id()) != signals.end() && event.level() > 0) {
 			if (data->last_event_time == -1) data->last_event_time = event.device_time(); //first value set time
 
-			//save values
-			auto& values = data->values[event.signal_id()];
-			values.push_back(event.level());
-			data->features[event.signal_id()] = calc_features(values.to_vector());
-
-			data->last_event_time = event.device_time();
-
-			//threshold
-			bool res = true;
-			for each (const auto& signal in data->features)
-			{
-				//if window_size = 1 then mean = value
-				res = res && (signal.second.mean > th_signal[signal.first]);
-			}
-			if (res) {
-				event_pa.level() = 1;
-			}
-
-			//confirmation
-			if (b_edge) {
-				if (data->activation_m.front() < th_edge) {
-					event_pa.level() += 1;
+			//decimated acceleration - the mean of the closed bin is used as the value of the signal
+			if (acc_bin > 0 && event.signal_id() == scgms::signal_Acceleration) {
+				if (data->acc.push(event.device_time(), event.level())) {
+					auto rc = push_value(seg_id, event.signal_id(), data->acc.last().time, data->acc.last().mean, event.device_time(), *data);
+					if (!Succeeded(rc)) {
+						return rc;
+					}
 				}
 			}
 			else {
-				event_pa.level() *= 2;
+				auto rc = push_value(seg_id, event.signal_id(), event.device_time(), event.level(), event.device_time(), *data);
+				if (!Succeeded(rc)) {
+					return rc;
+				}
 			}
-
-			//classification - test purposes only
-			if (b_class) {
-				auto res = classifier->classify(get_feature_vector(data->features));
-				event_pa.level() = res * 2;
+		}
+	}
+	else if (event.event_code() == scgms::NDevice_Event_Code::Time_Segment_Stop) {
+		//values of the last bins of the segment
+		PASegmentData* data = mSegments.find(event.segment_id(), event.device_time());
+		if (data && data->acc.close()) {
+			auto rc = push_value(event.segment_id(), scgms::signal_Acceleration, data->acc.last().time, data->acc.last().mean, event.device_time(), *data);
+			if (!Succeeded(rc)) {
+				return rc;
 			}
-
-			//send detected pa
-			auto rc = mOutput.Send(event_pa);
+		}
+		if (data && data->bin_end != -1) {
+			auto rc = flush_bin(event.segment_id(), event.device_time(), *data);
 			if (!Succeeded(rc)) {
 				return rc;
 			}
 		}
+
+		mSegments.erase(event.segment_id());
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+	}
+	else if (event.event_code() == scgms::NDevice_Event_Code::Shut_Down && features_export) {
+		try {
+			features_export->close();
+		}
+		catch (...) {
+			return E_FAIL;
+		}
 	}
 	
-	return mOutput.Send(event);
+	return metrics.send(mOutput, event);
+}
+
+HRESULT CPa_Detection::push_value(uint64_t seg_id, const GUID& signal, double value_time, double value, double device_time, PASegmentData& data)
+{
+	//aligned signals - values are collected to the bin and evaluated once the bin is closed
+	if (align_bin > 0) {
+		if (data.bin_end != -1 && value_time >= data.bin_end) {
+			auto rc = flush_bin(seg_id, device_time, data);
+			if (!Succeeded(rc)) {
+				return rc;
+			}
+		}
+		if (data.bin_end == -1) {
+			data.bin_end = (std::floor(value_time / align_bin) + 1) * align_bin;
+		}
+
+		auto& bin = data.bins[signal];
+		bin.sum += value;
+		bin.last = value;
+		bin.count++;
+		return S_OK;
+	}
+
+	//save values
+	auto& values = data.values[signal];
+	values.push_back(value_time, value);
+	{
+		detection::trace::CSpan span("CPa_Detection::calc_features", seg_id, device_time);
+		auto stage = metrics.stage(detection::NStage::Features);
+		data.features[signal] = calc_features(values);
+	}
+
+	data.last_event_time = value_time;
+
+	return evaluate(seg_id, device_time, data);
+}
+
+HRESULT CPa_Detection::evaluate(uint64_t seg_id, double device_time, PASegmentData& data)
+{
+	if (features_export) {
+		try {
+			features_export->push_back(get_feature_vector(data), data.label > 0 ? 1 : 0);
+		}
+		catch (const std::exception&) {
+			return E_FAIL;
+		}
+	}
+
+	//level of detected pa, the event is created only when it is sent
+	double pa = 0;
+
+	//threshold
+	bool res = true;
+	for (const auto& signal : data.features)
+	{
+		//if window_size = 1 then mean = value
+		res = res && (signal.second.mean > th_signal[signal.first]);
+	}
+	if (res) {
+		pa = 1;
+	}
+
+	//confirmation
+	if (b_edge) {
+		if (data.activation_m.front() < th_edge) {
+			pa += 1;
+		}
+	}
+	else {
+		pa *= 2;
+	}
+
+	//classification - test purposes only
+	if (classifier) {
+		ml& model = data.classifier ? *data.classifier : *classifier;
+		detection::trace::CSpan span("ml::classify", seg_id, device_time);
+		auto stage = metrics.stage(detection::NStage::Classification);
+		auto res = model.classify(get_feature_vector(data));
+		pa = res * 2;
+	}
+
+	//send detected pa
+	if (!detection_output.emit(data.emitted_pa, device_time, pa)) {
+		return S_OK;
+	}
+	auto event_pa = detection::level_event(detection::id_pa, detection::signal_pa, seg_id, device_time, pa);
+	metrics.emitted();
+	return metrics.send(mOutput, event_pa);
+}
+
+HRESULT CPa_Detection::flush_bin(uint64_t seg_id, double device_time, PASegmentData& data)
+{
+	//signals without a value in the bin keep their features
+	for (auto& bin : data.bins) {
+		if (bin.second.count == 0) continue;
+
+		auto& values = data.values[bin.first];
+		values.push_back(data.bin_end, align_mean ? bin.second.sum / bin.second.count : bin.second.last);
+		{
+			detection::trace::CSpan span("CPa_Detection::calc_features", seg_id, device_time);
+			auto stage = metrics.stage(detection::NStage::Features);
+			data.features[bin.first] = calc_features(values);
+		}
+
+		bin.second = SAlignBin();
+	}
+
+	data.last_event_time = data.bin_end;
+	data.bin_end = -1;
+
+	//the event follows the events already sent, so it has the time of the event closing the bin
+	return evaluate(seg_id, device_time, data);
+}
+
+twl<double> CPa_Detection::value_window() const
+{
+	return mean_duration > 0 ? twl<double>(mean_duration) : twl<double>(0, mean_window);
+}
+
+PASegmentData CPa_Detection::create_segment() const
+{
+	PASegmentData data;
+	data.activation_m = swl<double>(ist_window);
+	data.activation_m.push_front(0);
+	for (const GUID& s : signals) {
+		data.values.emplace(s, value_window());
+		data.features.emplace(s, SFeatures());
+	}
+	if (acc_bin > 0) data.acc = multires(acc_bin, acc_resolutions);
+	return data;
+}
+
+size_t CPa_Detection::state_size() const
+{
+	//time windows differ by the sampling rate of the segment, count windows are bounded by mean_window
+	size_t values = 0;
+	if (mean_duration > 0) {
+		mSegments.for_each([&values](uint64_t, double, const PASegmentData& data) {
+			for (const auto& window : data.values) values += window.second.size();
+		});
+	}
+	else {
+		values = mSegments.size() * signals.size() * mean_window;
+	}
+
+	//decimated acceleration keeps the mean and the energy of every bin within the resolution
+	for (double resolution : acc_resolutions) {
+		values += mSegments.size() * 2 * static_cast<size_t>(std::ceil(resolution / acc_bin));
+	}
+
+	return mSegments.size() * (sizeof(PASegmentData) + signals.size() * (sizeof(SFeatures) + sizeof(SAlignBin)) + ist_window * sizeof(double))
+		+ values * (sizeof(double) + sizeof(double));
+}
+
+bool CPa_Detection::save_state() const
+{
+	detection::CState_Snapshot state(detection::id_pa);
+	state.write(static_cast<uint64_t>(signals.size()));
+	for (const GUID& s : signals) state.write(s);
+	state.write(static_cast<uint64_t>(mean_window));
+	state.write(mean_duration);
+	state.write(align_bin);
+	state.write(align_mean);
+	state.write(acc_bin);
+	state.write(static_cast<uint64_t>(acc_resolutions.size()));
+	for (double resolution : acc_resolutions) state.write(resolution);
+	state.write(static_cast<uint64_t>(ist_window));
+
+	state.write(static_cast<uint64_t>(mSegments.size()));
+	mSegments.for_each([this, &state](uint64_t seg_id, double last_time, const PASegmentData& data) {
+		state.write(seg_id);
+		state.write(last_time);
+		state.write(data.last_event_time);
+		state.write(data.initialized);
+		state.write(data.prevL);
+		state.write(data.prevT);
+		state.write(data.activation_m);
+		for (const GUID& s : signals) {
+			const auto& f = data.features.at(s);
+			state.write(data.values.at(s));
+			state.write(f.mean);
+			state.write(f.median);
+			state.write(f.std);
+			state.write(f.quantile);
+
+			const auto bin = data.bins.find(s);
+			const SAlignBin values = bin != data.bins.end() ? bin->second : SAlignBin();
+			state.write(values.sum);
+			state.write(values.last);
+			state.write(static_cast<uint64_t>(values.count));
+		}
+		state.write(data.bin_end);
+		if (acc_bin > 0) state.write(data.acc);
+		for (const auto* emitted : { &data.emitted_activation, &data.emitted_pa }) {
+			state.write(emitted->level);
+			state.write(emitted->time);
+		}
+		state.write(data.label);
+		state.write(data.classifier != nullptr);
+		if (data.classifier) data.classifier->save_state(state);
+	});
+
+	return state.save(snapshot.path());
+}
+
+void CPa_Detection::restore_state()
+{
+	mSegments.clear();
+
+	detection::CState_Snapshot state(detection::id_pa);
+	if (!snapshot.enabled() || !state.load(snapshot.path()) || state.read_uint() != signals.size()) {
+		return;
+	}
+	for (const GUID& s : signals) {
+		if (state.read_guid() != s) return;
+	}
+	if (state.read_uint() != mean_window || state.read_double() != mean_duration
+		|| state.read_double() != align_bin || state.read_bool() != align_mean || state.read_double() != acc_bin
+		|| state.read_uint() != acc_resolutions.size()) {
+		return;
+	}
+	for (double resolution : acc_resolutions) {
+		if (state.read_double() != resolution) return;
+	}
+	if (state.read_uint() != ist_window) {
+		return;
+	}
+
+	const uint64_t count = state.read_uint();
+	for (uint64_t i = 0; i < count && state.good(); ++i) {
+		const uint64_t seg_id = state.read_uint();
+		const double last_time = state.read_double();
+
+		PASegmentData data = create_segment();
+		data.last_event_time = state.read_double();
+		data.initialized = state.read_bool();
+		data.prevL = state.read_double();
+		data.prevT = state.read_double();
+		state.read(data.activation_m);
+		for (const GUID& s : signals) {
+			state.read(data.values.at(s));
+
+			SFeatures& f = data.features.at(s);
+			f.mean = state.read_double();
+			f.median = state.read_double();
+			f.std = state.read_double();
+			f.quantile = state.read_double();
+
+			SAlignBin bin;
+			bin.sum = state.read_double();
+			bin.last = state.read_double();
+			bin.count = static_cast<size_t>(state.read_uint());
+			data.bins.emplace(s, bin);
+		}
+		data.bin_end = state.read_double();
+		if (acc_bin > 0) state.read(data.acc);
+		for (auto* emitted : { &data.emitted_activation, &data.emitted_pa }) {
+			emitted->level = state.read_double();
+			emitted->time = state.read_double();
+		}
+		data.label = state.read_double();
+		if (state.read_bool()) {
+			data.classifier = std::make_shared<ml>('b');
+			if (!data.classifier->load_state(state)) {
+				mSegments.clear();
+				return;
+			}
+		}
+
+		mSegments.insert(seg_id, last_time, std::move(data));
+	}
+
+	if (!state.finished()) {
+		mSegments.clear();
+	}
 }
 
 double CPa_Detection::activation(scgms::UDevice_Event& event, PASegmentData& data)
@@ -254,22 +702,30 @@ double CPa_Detection::activation(scgms::UDevice_Event& event, PASegmentData& dat
 	return act_m;
 }
 
-SFeatures CPa_Detection::calc_features(std::vector<double> data) {
+SFeatures CPa_Detection::calc_features(const twl<double>& values) {
 	SFeatures features = SFeatures();
 
-	features.mean = mean(data);
+	features.mean = values.mean();
+	features.std = values.std();
+
+	//order statistics need the sorted copy of the window
+	const std::vector<double> data = values.to_vector();
 	features.median = median(data);
-	features.std = std(data);
 	features.quantile = quantile_diff(data);
 
 	return features;
 }
 
-std::vector<double> CPa_Detection::get_feature_vector(std::map<GUID, SFeatures> features)
+size_t CPa_Detection::feature_count() const
+{
+	return signals.size() * 4 + (acc_bin > 0 ? acc_resolutions.size() * 2 : 0);
+}
+
+std::vector<double> CPa_Detection::get_feature_vector(const PASegmentData& data)
 {
 	std::vector<double> vec;
 
-	for each (const auto& var in features)
+	for (const auto& var : data.features)
 	{
 		auto f = var.second;
 		vec.push_back(f.mean);
@@ -278,5 +734,11 @@ std::vector<double> CPa_Detection::get_feature_vector(std::map<GUID, SFeatures>
 		vec.push_back(f.quantile);
 	}
 
+	//mean and RMS of the decimated acceleration in every resolution
+	for (size_t i = 0; i < data.acc.resolutions(); ++i) {
+		vec.push_back(data.acc.mean(i));
+		vec.push_back(std::sqrt(data.acc.energy(i)));
+	}
+
 	return vec;
 }
\ No newline at end of file
@@ -64,10 +64,18 @@
 #include <vector>
 #include <map>
 #include <numeric>
+#include <sstream>
 
 #include "descriptor.h"
 #include "swl.h"
+#include "twl.h"
+#include "multires.h"
+#include "segment_store.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "emission.h"
 #include "ML/ml.h"
+#include "ML/dataset.h"
 
 #pragma warning( push )
 #pragma warning( disable : 4250 ) // C4250 - 'class1' : inherits 'class2::member' via dominance
@@ -79,6 +87,13 @@ struct SFeatures {
     double quantile = 0;
 };
 
+/*Values of the signal collected to the alignment bin*/
+struct SAlignBin {
+    double sum = 0;
+    double last = 0;
+    size_t count = 0;
+};
+
 struct PASegmentData {
     double last_event_time = -1;
     
@@ -87,8 +102,24 @@ struct PASegmentData {
     double prevT = -1;
     swl<double> activation_m;
 
-    std::map<GUID, swl<double>> values;
+    std::map<GUID, twl<double>> values;
     std::map<GUID, SFeatures> features;
+
+    //alignment bin of the signals, end of the open bin or -1
+    double bin_end = -1;
+    std::map<GUID, SAlignBin> bins;
+
+    //decimated acceleration with its multi-resolution aggregates
+    multires acc;
+
+    //last sent activation and detected pa
+    detection::TEmission_State emitted_activation;
+    detection::TEmission_State emitted_pa;
+
+    //classifier adapted to the segment by online learning
+    std::shared_ptr<ml> classifier;
+    //last confirmed activity label
+    double label = 0;
 };
 
 /*Filter for physical activity detection*/
@@ -104,20 +135,64 @@ public:
 	virtual HRESULT IfaceCalling QueryInterface(const GUID* riid, void** ppvObj) override final;
 
 private:
-    std::map<uint64_t, PASegmentData> mSegments;
+    segment_store<PASegmentData> mSegments;
 
     std::vector<GUID> signals;
     std::map<GUID, double> th_signal;
 
     bool b_mean = false;
     size_t mean_window = 6;
+    //length of the time window of the features, count window of mean_window values if zero
+    double mean_duration = 0;
+    /*Empty window of the signal values*/
+    twl<double> value_window() const;
+    /*Empty segment state for the current configuration*/
+    PASegmentData create_segment() const;
+
+    //alignment of the signals to the common time grid, features are evaluated once per bin if align_bin > 0
+    double align_bin = 0;
+    //mean of the values in the bin, last value otherwise
+    bool align_mean = false;
+    //decimation of the acceleration to bins, acc_bin = 0 passes every sample to the features
+    double acc_bin = 0;
+    std::vector<double> acc_resolutions;
+
+    /*Push the value of the signal to the window (or to the alignment bin) and evaluate the features*/
+    HRESULT push_value(uint64_t seg_id, const GUID& signal, double value_time, double value, double device_time, PASegmentData& data);
+    /*Push the values of the closed bin to the windows and evaluate the features*/
+    HRESULT flush_bin(uint64_t seg_id, double device_time, PASegmentData& data);
+    /*Threshold or classify the current features and send the detected pa*/
+    HRESULT evaluate(uint64_t seg_id, double device_time, PASegmentData& data);
 
     //classifier use - test purposes only
     bool b_class = false;
     char class_type = 'l';
-    std::string class_path = "0-pa-export.csv";
+    std::filesystem::path class_path = "0-pa-export.csv";
+    std::filesystem::path class_model;
     std::unique_ptr<ml> classifier;
 
+    //online learning of the classifier from confirmed activity labels
+    bool b_online = false;
+    GUID label_signal = scgms::signal_Physical_Activity;
+
+    //export of features to the binary dataset for classifier training
+    std::unique_ptr<dataset_writer> features_export;
+
+    //output policies of the activation and the detected pa
+    detection::CEmission_Policy activation_output;
+    detection::CEmission_Policy detection_output;
+
+    detection::CFilter_Metrics metrics{ L"PA detection" };
+    /*Approximate size of the segment state in bytes*/
+    size_t state_size() const;
+
+    /*Snapshot of the segment state including the classifiers adapted by online learning*/
+    detection::CSnapshot_Schedule snapshot;
+    /*Write the segment state to the snapshot file*/
+    bool save_state() const;
+    /*Restore the segment state from the snapshot file, cold start if the snapshot is missing or does not match*/
+    void restore_state();
+
     //edge detection
     bool b_edge = false;
     GUID ist_signal = Invalid_GUID;
@@ -130,10 +205,12 @@ private:
     /*Calc activation function*/
     double activation(scgms::UDevice_Event& event, PASegmentData& data);
 
-    /*Calc features from the given vector*/
-    SFeatures calc_features(std::vector<double>);
+    /*Calc features from the given window, mean and std are kept incrementally by the window*/
+    SFeatures calc_features(const twl<double>& values);
     /*Transform features to the vector*/
-    std::vector<double> get_feature_vector(std::map<GUID, SFeatures> features);
+    std::vector<double> get_feature_vector(const PASegmentData& data);
+    /*Length of the feature vector, 4 per signal and 2 per acceleration resolution*/
+    size_t feature_count() const;
 
 
 
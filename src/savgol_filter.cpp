@@ -52,6 +52,9 @@
 
 #include "savgol_filter.h"
 #include "descriptor.h"
+#include "trace.h"
+
+#include <cmath>
 
 CSavgol_Filter::CSavgol_Filter(scgms::IFilter* output) : CBase_Filter(output) {
 	//
@@ -86,45 +89,203 @@ HRESULT IfaceCalling CSavgol_Filter::Do_Configure(scgms::SFilter_Configuration c
 		return E_INVALIDARG;
 	}
 
+	send_derivative = configuration.Read_Bool(detection::rsSavgolDerivative);
+	coefficients.configure(window, degree);
+
+	auto ttl = configuration.Read_Int(detection::rsSegmentTTL, 0);
+	auto max_segments = configuration.Read_Int(detection::rsMaxSegments, 0);
+	if (ttl < 0 || max_segments < 0) {
+		error_description.push(L"Segment TTL and max segments must be non-negative!");
+		return E_INVALIDARG;
+	}
+	mSegments.set_limits(ttl * scgms::One_Minute, static_cast<size_t>(max_segments));
+
+	metrics.set_period(configuration.Read_Int(detection::rsMetricsPeriod, 0) * scgms::One_Minute);
+
+	auto snapshot_path = configuration.Read_File_Path(detection::rsSnapshotPath);
+	if (std::filesystem::is_directory(snapshot_path)) snapshot_path.clear();
+	snapshot.configure(snapshot_path, configuration.Read_Int(detection::rsSnapshotPeriod, 0) * scgms::One_Minute);
+	restore_state();
+
 	return S_OK;
 }
 
 HRESULT IfaceCalling CSavgol_Filter::Do_Execute(scgms::UDevice_Event event) {
-	
+	auto scope = metrics.measure(event);
+
+	if (mSegments.evict(event.device_time()) > 0) {
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+	}
+
+	if (metrics.report_due(event.device_time())) {
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
+		auto report = metrics.report(detection::id_savgol, event);
+		auto rc = metrics.send(mOutput, report);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
+	if (snapshot.due(event) && !save_state()) {
+		auto warning = detection::snapshot_warning(detection::id_savgol, event);
+		auto rc = metrics.send(mOutput, warning);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
+
 	if (event.is_level_event() && event.signal_id() == input_signal) {
 		
-		auto seg_id = event.segment_id();
-		auto it = mSegments.emplace(seg_id, swl<double>(3 * window));
+		auto& ist = mSegments.get(event.segment_id(), event.device_time(), [this]() { return SavgolSegmentData(coefficients.size()); });
 
-		auto rc = process(event, it.first->second);
+		auto rc = process(event, ist);
 		if (!Succeeded(rc)) {
 			return rc;
 		}
 	}
 	else if (event.event_code() == scgms::NDevice_Event_Code::Time_Segment_Stop) {
 		mSegments.erase(event.segment_id());
+		metrics.state(mSegments.size(), state_size(), mSegments.evicted());
 	}
 
-	return mOutput.Send(event);
+	return metrics.send(mOutput, event);
 }
 
-HRESULT CSavgol_Filter::process(scgms::UDevice_Event &event, swl<double>& ist)
+HRESULT CSavgol_Filter::process(scgms::UDevice_Event &event, SavgolSegmentData& ist)
 {
+	detection::trace::CSpan span("CSavgol_Filter::process", event.segment_id(), event.device_time());
+
 	double _ist = 0;
-	ist.push_back(event.level());
+	double derivative = 0;
+	bool smoothed = false;
+	{
+		auto stage = metrics.stage(detection::NStage::Smoothing);
+		ist.push_back(event.level(), event.device_time());
+		smoothed = coefficients.apply(ist, _ist, derivative);
+	}
+	if (!smoothed) {
+		return S_OK;
+	}
 
-	auto vec = std::vector<double>(ist.begin(), ist.end());
-	//_ist = (sg_smooth(vec, window, degree).back());
-	auto vec2 = sg_smooth(vec, window, degree);
-	//_ist = vec2[(int)(window / 2)]; //-2 => value before last one
+	//send derivative before the smoothed signal, so the detection has the slope of the sample
+	if (send_derivative) {
+		auto d = detection::level_event(detection::id_savgol, detection::signal_savgol_derivative, event.segment_id(), event.device_time(), derivative);
+		metrics.emitted();
+		auto rc = metrics.send(mOutput, d);
+		if (!Succeeded(rc)) {
+			return rc;
+		}
+	}
 
 	//send smoothed signal
-	scgms::UDevice_Event e(scgms::NDevice_Event_Code::Level);
-	e.device_id() = detection::id_savgol;
-	e.signal_id() = detection::signal_savgol;
-	e.segment_id() = event.segment_id();
-	e.device_time() = event.device_time();
-	e.level() = _ist;
-
-	return mOutput.Send(e);
+	auto e = detection::level_event(detection::id_savgol, detection::signal_savgol, event.segment_id(), event.device_time(), _ist);
+	metrics.emitted();
+	return metrics.send(mOutput, e);
+}
+
+bool CSavgol_Filter::save_state() const
+{
+	detection::CState_Snapshot state(detection::id_savgol);
+	state.write(static_cast<uint64_t>(window));
+	state.write(static_cast<uint64_t>(mSegments.size()));
+	mSegments.for_each([&state](uint64_t seg_id, double last_time, const SavgolSegmentData& ist) {
+		state.write(seg_id);
+		state.write(last_time);
+		state.write(ist.levels);
+		state.write(ist.times);
+	});
+
+	return state.save(snapshot.path());
+}
+
+void CSavgol_Filter::restore_state()
+{
+	mSegments.clear();
+
+	detection::CState_Snapshot state(detection::id_savgol);
+	if (!snapshot.enabled() || !state.load(snapshot.path()) || state.read_uint() != window) {
+		return;
+	}
+
+	const uint64_t count = state.read_uint();
+	for (uint64_t i = 0; i < count && state.good(); ++i) {
+		const uint64_t seg_id = state.read_uint();
+		const double last_time = state.read_double();
+		SavgolSegmentData ist(coefficients.size());
+		state.read(ist.levels);
+		state.read(ist.times);
+		if (ist.levels.size() > coefficients.size() || ist.levels.size() != ist.times.size()) {
+			break;
+		}
+		mSegments.insert(seg_id, last_time, std::move(ist));
+	}
+
+	if (!state.finished()) {
+		mSegments.clear();
+	}
+}
+
+void detection::CSavgol_Coefficients::configure(size_t window, size_t degree)
+{
+	//positions of the samples scaled to <-1, 0>, the newest sample is at 0
+	const size_t n = 2 * window + 1;
+	const size_t m = degree + 1;
+	std::vector<std::vector<double>> A(n, std::vector<double>(m));
+	for (size_t k = 0; k < n; ++k) {
+		const double u = (static_cast<double>(k) - static_cast<double>(n - 1)) / static_cast<double>(n - 1);
+		double p = 1;
+		for (size_t j = 0; j < m; ++j, p *= u) A[k][j] = p;
+	}
+
+	//normal equations (A^T A) X = A^T, row j of X are the weights of the polynomial coefficient j
+	std::vector<std::vector<double>> M(m, std::vector<double>(m + n, 0.0));
+	for (size_t i = 0; i < m; ++i) {
+		for (size_t k = 0; k < n; ++k) {
+			for (size_t j = 0; j < m; ++j) M[i][j] += A[k][i] * A[k][j];
+			M[i][m + k] = A[k][i];
+		}
+	}
+
+	//Gauss-Jordan elimination with partial pivoting
+	for (size_t c = 0; c < m; ++c) {
+		size_t pivot = c;
+		for (size_t r = c + 1; r < m; ++r) {
+			if (std::fabs(M[r][c]) > std::fabs(M[pivot][c])) pivot = r;
+		}
+		std::swap(M[c], M[pivot]);
+
+		const double d = M[c][c];
+		for (auto& x : M[c]) x /= d;
+		for (size_t r = 0; r < m; ++r) {
+			if (r == c || M[r][c] == 0) continue;
+			const double f = M[r][c];
+			for (size_t j = c; j < m + n; ++j) M[r][j] -= f * M[c][j];
+		}
+	}
+
+	//value at 0 is the constant coefficient, derivative per sample is the linear one scaled back from <-1, 0>
+	value.assign(M[0].begin() + m, M[0].end());
+	slope.resize(n);
+	for (size_t k = 0; k < n; ++k) slope[k] = M[1][m + k] / static_cast<double>(n - 1);
+}
+
+bool detection::CSavgol_Coefficients::apply(const SavgolSegmentData& data, double& smoothed, double& derivative) const
+{
+	const size_t n = value.size();
+	if (data.levels.size() < n) {
+		return false;
+	}
+
+	double v = 0;
+	double d = 0;
+	auto level = data.levels.end() - n;
+	for (size_t k = 0; k < n; ++k, ++level) {
+		v += value[k] * *level;
+		d += slope[k] * *level;
+	}
+
+	const double step = (data.times.back() - *(data.times.end() - n)) / static_cast<double>(n - 1) / scgms::One_Minute;
+	smoothed = v;
+	derivative = step > 0 ? d / step : 0;
+	return true;
 }
@@ -61,10 +61,44 @@
 
 #include "descriptor.h"
 #include "swl.h"
-#include "ML/SGSmooth.hpp"
+#include "segment_store.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "emission.h"
 
 
 
+/*Last samples of the segment for the Savitzky-Golay fit*/
+struct SavgolSegmentData {
+	swl<double> levels;
+	swl<double> times;
+
+	explicit SavgolSegmentData(size_t size = 0) : levels(size), times(size) {};
+
+	void push_back(double level, double device_time) {
+		levels.push_back(level);
+		times.push_back(device_time);
+	}
+};
+
+namespace detection {
+	/*Savitzky-Golay fit of the last 2 * window + 1 samples evaluated at the newest sample
+	 * Weights of the smoothed value and of the first derivative are computed once by the least squares
+	 * fit of the polynomial, one pass over the window yields both.
+	 */
+	class CSavgol_Coefficients {
+	public:
+		void configure(size_t window, size_t degree);
+		/*Number of samples of the fit*/
+		size_t size() const { return value.size(); }
+		/*Smoothed value and derivative per minute (samples are assumed to be equidistant), false until the window is filled*/
+		bool apply(const SavgolSegmentData& data, double& smoothed, double& derivative) const;
+	private:
+		std::vector<double> value;
+		std::vector<double> slope;
+	};
+}
+
 #pragma warning( push )
 #pragma warning( disable : 4250 ) // C4250 - 'class1' : inherits 'class2::member' via dominance
 
@@ -84,10 +118,22 @@ private:
 	GUID input_signal = scgms::signal_IG;
 	size_t window = 21;
 	size_t degree = 3;
+	bool send_derivative = false;
+
+	detection::CSavgol_Coefficients coefficients;
+	segment_store<SavgolSegmentData> mSegments;
+
+	detection::CFilter_Metrics metrics{ L"Savitzky-Golay filter" };
+	/*Approximate size of the segment state in bytes*/
+	size_t state_size() const { return mSegments.size() * 2 * coefficients.size() * sizeof(double); }
 
-	std::map<uint64_t, swl<double>> mSegments;
+	detection::CSnapshot_Schedule snapshot;
+	/*Write the segment state to the snapshot file*/
+	bool save_state() const;
+	/*Restore the segment state from the snapshot file, cold start if the snapshot is missing or does not match*/
+	void restore_state();
 
-	HRESULT process(scgms::UDevice_Event &event, swl<double>& ist);
+	HRESULT process(scgms::UDevice_Event &event, SavgolSegmentData& ist);
 };
 
 #pragma warning( pop )
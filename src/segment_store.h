@@ -0,0 +1,129 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+/*Per-segment state of a filter with eviction of idle segments
+ * Segments are kept in LRU order. A segment is evicted when it was not used for ttl of device time
+ * or when the number of segments exceeds max_segments. TTL assumes a common device time of the
+ * segments (live stream). Zero limits disable the eviction.
+ */
+template <class T>
+class segment_store
+{
+public:
+	struct entry {
+		T value;
+		double last_time;
+		std::list<uint64_t>::iterator lru;
+	};
+
+	using map_type = std::unordered_map<uint64_t, entry>;
+
+	void set_limits(double ttl, size_t max_segments) {
+		_ttl = ttl;
+		_max_segments = max_segments;
+	}
+
+	/*Segment state or nullptr, the segment is refreshed*/
+	T* find(uint64_t segment, double device_time) {
+		auto it = _segments.find(segment);
+		if (it == _segments.end()) return nullptr;
+
+		touch(it->second, device_time);
+		return &it->second.value;
+	}
+
+	/*Segment state, created by create() if the segment does not exist*/
+	template <class F>
+	T& get(uint64_t segment, double device_time, F&& create) {
+		auto it = _segments.find(segment);
+		if (it == _segments.end()) {
+			_lru.push_front(segment);
+			it = _segments.emplace(segment, entry{ create(), device_time, _lru.begin() }).first;
+
+			//new segment is at the front, the cap evicts the least recently used ones
+			while (_max_segments > 0 && _segments.size() > _max_segments) {
+				erase(_lru.back());
+				_evicted++;
+			}
+		}
+		else {
+			touch(it->second, device_time);
+		}
+
+		return it->second.value;
+	}
+
+	/*Inserts restored segment as the most recently used one*/
+	void insert(uint64_t segment, double last_time, T value) {
+		erase(segment);
+		_lru.push_front(segment);
+		_segments.emplace(segment, entry{ std::move(value), last_time, _lru.begin() });
+	}
+
+	/*Calls f(segment, last_time, value) from the least recently used segment*/
+	template <class F>
+	void for_each(F&& f) const {
+		for (auto it = _lru.rbegin(); it != _lru.rend(); ++it) {
+			const auto& e = _segments.at(*it);
+			f(*it, e.last_time, e.value);
+		}
+	}
+
+	bool erase(uint64_t segment) {
+		auto it = _segments.find(segment);
+		if (it == _segments.end()) return false;
+
+		_lru.erase(it->second.lru);
+		_segments.erase(it);
+		return true;
+	}
+
+	/*Evicts segments idle for longer than ttl, returns the number of evicted segments*/
+	size_t evict(double device_time) {
+		size_t count = 0;
+		while (_ttl > 0 && !_lru.empty()) {
+			auto it = _segments.find(_lru.back());
+			if (device_time - it->second.last_time <= _ttl) break;
+
+			_lru.pop_back();
+			_segments.erase(it);
+			count++;
+		}
+		_evicted += count;
+		return count;
+	}
+
+	void clear() {
+		_segments.clear();
+		_lru.clear();
+	}
+
+	size_t size() const { return _segments.size(); }
+	bool empty() const { return _segments.empty(); }
+	/*Total number of evicted segments*/
+	uint64_t evicted() const { return _evicted; }
+
+	typename map_type::iterator begin() { return _segments.begin(); }
+	typename map_type::iterator end() { return _segments.end(); }
+	typename map_type::const_iterator begin() const { return _segments.begin(); }
+	typename map_type::const_iterator end() const { return _segments.end(); }
+
+private:
+	map_type _segments;
+	std::list<uint64_t> _lru;
+	double _ttl = 0;
+	size_t _max_segments = 0;
+	uint64_t _evicted = 0;
+
+	void touch(entry& e, double device_time) {
+		e.last_time = device_time;
+		_lru.splice(_lru.begin(), _lru, e.lru);
+	}
+};
@@ -0,0 +1,147 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#include "snapshot.h"
+#include "ML/sklearn/hash.h"
+
+#include <fstream>
+#include <random>
+#include <system_error>
+
+namespace {
+	const char snapshot_magic[4] = { 'S', 'C', 'S', 'S' };
+
+	struct TSnapshot_Header {
+		char magic[4];
+		uint32_t version;
+		GUID filter;
+		uint64_t size;
+		uint64_t checksum;
+	};
+
+	static_assert(sizeof(TSnapshot_Header) == 40, "snapshot header must be packed");
+
+	uint64_t checksum(const std::vector<char>& data) {
+		meta::util::murmur_hash<8> hash(0);
+		hash(data.data(), data.size());
+		return static_cast<uint64_t>(static_cast<std::size_t>(hash));
+	}
+}
+
+namespace detection {
+
+	bool CState_Snapshot::save(const std::filesystem::path& path) const {
+		TSnapshot_Header h;
+		std::memcpy(h.magic, snapshot_magic, sizeof(snapshot_magic));
+		h.version = version;
+		h.filter = filter;
+		h.size = payload.size();
+		h.checksum = checksum(payload);
+
+		std::filesystem::path tmp = path;
+		tmp += "." + std::to_string(std::random_device{}()) + ".tmp";
+		{
+			std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) return false;
+			file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+			file.write(payload.data(), payload.size());
+			if (!file) {
+				file.close();
+				std::error_code ec;
+				std::filesystem::remove(tmp, ec);
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tmp, path, ec);
+		if (ec) {
+			std::filesystem::remove(tmp, ec);
+			return false;
+		}
+		return true;
+	}
+
+	bool CState_Snapshot::load(const std::filesystem::path& path) {
+		payload.clear();
+		position = 0;
+		failed = true;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) return false;
+
+		TSnapshot_Header h;
+		file.read(reinterpret_cast<char*>(&h), sizeof(h));
+		if (!file || std::memcmp(h.magic, snapshot_magic, sizeof(snapshot_magic)) != 0) return false;
+		if (h.version != version || h.filter != filter) return false;
+
+		payload.resize(static_cast<size_t>(h.size));
+		file.read(payload.data(), payload.size());
+		if (!file || checksum(payload) != h.checksum) {
+			payload.clear();
+			return false;
+		}
+
+		failed = false;
+		return true;
+	}
+
+	scgms::UDevice_Event snapshot_warning(const GUID& device_id, scgms::UDevice_Event& event) {
+		scgms::UDevice_Event e(scgms::NDevice_Event_Code::Warning);
+		e.device_id() = device_id;
+		e.signal_id() = Invalid_GUID;
+		e.segment_id() = event.segment_id();
+		e.device_time() = event.device_time();
+		e.info.set(L"Cannot write the snapshot!");
+		return e;
+	}
+}
@@ -0,0 +1,257 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#pragma once
+
+#include <rtl/FilterLib.h>
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "twl.h"
+#include "multires.h"
+
+namespace detection {
+
+	/*Versioned binary snapshot of the filter state
+	 * Header with filter id, payload size and checksum followed by the payload written by the filter.
+	 * Reading past the end of the payload returns zeros and clears good().
+	 * The version is shared by the payload layouts of all filters and must be increased whenever any of them changes,
+	 * snapshots of other versions are ignored (cold start).
+	 */
+	class CState_Snapshot {
+	public:
+		//2 - alignment bins, multi-resolution aggregates, emission state, evaluation, ensemble and PA classifiers
+		static constexpr uint32_t version = 3;
+
+		explicit CState_Snapshot(const GUID& filter) : filter(filter) {}
+
+		/*Writes the snapshot to a temporary file and renames it, the previous snapshot stays valid on failure*/
+		bool save(const std::filesystem::path& path) const;
+		/*Loads and validates the snapshot of the filter*/
+		bool load(const std::filesystem::path& path);
+
+		void write(uint64_t value) { write_raw(&value, sizeof(value)); }
+		void write(double value) { write_raw(&value, sizeof(value)); }
+		void write(bool value) { write(static_cast<uint64_t>(value)); }
+		void write(const GUID& value) { write_raw(&value, sizeof(value)); }
+
+		template <class T>
+		void write(const std::deque<T>& values) {
+			write(static_cast<uint64_t>(values.size()));
+			for (const T& value : values) write_raw(&value, sizeof(T));
+		}
+
+		template <class T>
+		void write(const std::vector<T>& values) {
+			write(static_cast<uint64_t>(values.size()));
+			if (!values.empty()) write_raw(values.data(), values.size() * sizeof(T));
+		}
+
+		template <class T>
+		void write(const twl<T>& values) {
+			write(static_cast<uint64_t>(values.size()));
+			for (size_t i = 0; i < values.size(); ++i) {
+				write(values.time(i));
+				write_raw(&values.value(i), sizeof(T));
+			}
+		}
+
+		void write(const multires& values) {
+			write(values._end);
+			write(values._sum);
+			write(values._sum_sq);
+			write(static_cast<uint64_t>(values._count));
+			write(values._last.time);
+			write(values._last.mean);
+			write(values._last.energy);
+			for (size_t i = 0; i < values.resolutions(); ++i) {
+				write(values._means[i]);
+				write(values._energies[i]);
+			}
+		}
+
+		uint64_t read_uint() { uint64_t value = 0; read_raw(&value, sizeof(value)); return value; }
+		double read_double() { double value = 0; read_raw(&value, sizeof(value)); return value; }
+		bool read_bool() { return read_uint() != 0; }
+		GUID read_guid() { GUID value = Invalid_GUID; read_raw(&value, sizeof(value)); return value; }
+
+		/*Reads values to the window (swl), count is limited by the size of the payload*/
+		template <class T>
+		void read(std::deque<T>& values) {
+			values.clear();
+			const uint64_t count = read_uint();
+			if (count > (payload.size() - position) / sizeof(T)) {
+				failed = true;
+				return;
+			}
+			for (uint64_t i = 0; i < count; ++i) {
+				T value;
+				read_raw(&value, sizeof(T));
+				values.std::deque<T>::push_back(value);
+			}
+		}
+
+		/*Reads values to the array, count is limited by the size of the payload*/
+		template <class T>
+		void read(std::vector<T>& values) {
+			values.clear();
+			const uint64_t count = read_uint();
+			if (count > (payload.size() - position) / sizeof(T)) {
+				failed = true;
+				return;
+			}
+			values.resize(static_cast<size_t>(count));
+			if (!values.empty()) read_raw(values.data(), values.size() * sizeof(T));
+		}
+
+		/*Reads (time, value) pairs to the time window, its horizon and count bound evict the stale values*/
+		template <class T>
+		void read(twl<T>& values) {
+			values.clear();
+			const uint64_t count = read_uint();
+			if (count > (payload.size() - position) / (sizeof(double) + sizeof(T))) {
+				failed = true;
+				return;
+			}
+			for (uint64_t i = 0; i < count; ++i) {
+				const double time = read_double();
+				T value;
+				read_raw(&value, sizeof(T));
+				values.push_back(time, value);
+			}
+		}
+
+		/*Reads the open bin and the windows, the resolutions are given by the configuration of the values*/
+		void read(multires& values) {
+			values._end = read_double();
+			values._sum = read_double();
+			values._sum_sq = read_double();
+			values._count = static_cast<size_t>(read_uint());
+			values._last.time = read_double();
+			values._last.mean = read_double();
+			values._last.energy = read_double();
+			for (size_t i = 0; i < values.resolutions(); ++i) {
+				read(values._means[i]);
+				read(values._energies[i]);
+			}
+		}
+
+		/*All reads were within the payload*/
+		bool good() const { return !failed; }
+		/*Whole payload was read*/
+		bool finished() const { return !failed && position == payload.size(); }
+
+	private:
+		GUID filter;
+		std::vector<char> payload;
+		size_t position = 0;
+		bool failed = false;
+
+		void write_raw(const void* data, size_t size) {
+			const char* p = static_cast<const char*>(data);
+			payload.insert(payload.end(), p, p + size);
+		}
+
+		void read_raw(void* data, size_t size) {
+			if (failed || payload.size() - position < size) {
+				failed = true;
+				std::memset(data, 0, size);
+				return;
+			}
+			std::memcpy(data, payload.data() + position, size);
+			position += size;
+		}
+	};
+
+	/*Warning event about the snapshot that could not be written*/
+	scgms::UDevice_Event snapshot_warning(const GUID& device_id, scgms::UDevice_Event& event);
+
+	/*Periodic and shutdown snapshots of a filter, period in device time*/
+	class CSnapshot_Schedule {
+	public:
+		void configure(const std::filesystem::path& path, double period) {
+			snapshot_path = path;
+			snapshot_period = period;
+			last_snapshot = -1;
+		}
+
+		bool enabled() const { return !snapshot_path.empty(); }
+		const std::filesystem::path& path() const { return snapshot_path; }
+
+		/*Periodic snapshot or the snapshot on shut down*/
+		bool due(scgms::UDevice_Event& event) {
+			if (!enabled()) return false;
+			if (event.event_code() == scgms::NDevice_Event_Code::Shut_Down) return true;
+			if (snapshot_period <= 0) return false;
+
+			const double device_time = event.device_time();
+			if (last_snapshot < 0) {
+				last_snapshot = device_time;
+				return false;
+			}
+			if (device_time - last_snapshot < snapshot_period) return false;
+
+			last_snapshot = device_time;
+			return true;
+		}
+
+	private:
+		std::filesystem::path snapshot_path;
+		double snapshot_period = 0;
+		double last_snapshot = -1;
+	};
+}
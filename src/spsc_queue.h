@@ -0,0 +1,107 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+/*Bounded lock-free queue of one producer thread and one consumer thread
+ * Capacity is rounded up to a power of two. Items are constructed in the slot on push and destroyed
+ * right after they are consumed, so an empty slot holds no resources. Both indices grow monotonically,
+ * each side keeps a cached copy of the other index, so the shared cache lines are touched only when
+ * the cached value says the queue is full (producer) or empty (consumer).
+ */
+template <class T>
+class spsc_queue
+{
+public:
+	explicit spsc_queue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		_mask = size - 1;
+		_items = std::make_unique<slot[]>(size);
+	}
+
+	~spsc_queue() {
+		consume(capacity(), [](T&) {});
+	}
+
+	spsc_queue(const spsc_queue&) = delete;
+	spsc_queue& operator=(const spsc_queue&) = delete;
+
+	size_t capacity() const { return _mask + 1; }
+
+	/*Approximate number of queued items, exact when called by the producer or the consumer while the other side is idle*/
+	size_t size() const {
+		return _head.value.load(std::memory_order_acquire) - _tail.value.load(std::memory_order_acquire);
+	}
+
+	/*Producer only, returns false when the queue is full*/
+	bool try_push(T&& item) {
+		const size_t head = _head.value.load(std::memory_order_relaxed);
+		if (head - _tail_cache == capacity()) {
+			_tail_cache = _tail.value.load(std::memory_order_acquire);
+			if (head - _tail_cache == capacity()) {
+				return false;
+			}
+		}
+
+		new (&_items[head & _mask]) T(std::move(item));
+		//sequentially consistent store pairs with empty() of a consumer going to sleep
+		_head.value.store(head + 1, std::memory_order_seq_cst);
+		return true;
+	}
+
+	/*Consumer only, calls f(T&) for up to max_count items and releases their slots at once
+	 * Returns the number of consumed items.
+	 */
+	template <class F>
+	size_t consume(size_t max_count, F&& f) {
+		const size_t tail = _tail.value.load(std::memory_order_relaxed);
+		if (_head_cache == tail) {
+			_head_cache = _head.value.load(std::memory_order_acquire);
+			if (_head_cache == tail) {
+				return 0;
+			}
+		}
+
+		size_t count = _head_cache - tail;
+		if (count > max_count) count = max_count;
+
+		for (size_t i = 0; i < count; i++) {
+			T* item = std::launder(reinterpret_cast<T*>(&_items[(tail + i) & _mask]));
+			f(*item);
+			item->~T();
+		}
+
+		_tail.value.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	/*Consumer only, sequentially consistent load pairs with try_push*/
+	bool empty() const {
+		return _head.value.load(std::memory_order_seq_cst) == _tail.value.load(std::memory_order_relaxed);
+	}
+
+private:
+	//producer and consumer indices on separate cache lines
+	struct alignas(64) index {
+		std::atomic<size_t> value{ 0 };
+	};
+
+	using slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+	std::unique_ptr<slot[]> _items;
+	size_t _mask = 0;
+
+	index _head;
+	alignas(64) size_t _tail_cache = 0;	//producer's copy of _tail
+
+	index _tail;
+	alignas(64) size_t _head_cache = 0;	//consumer's copy of _head
+};
@@ -28,5 +28,6 @@ public:
 		return std::vector(std::deque<T>::begin(), std::deque<T>::end());
 	}
 
-	const size_t _width;
+	//not const, so the windows can be assigned
+	size_t _width;
 };
\ No newline at end of file
@@ -0,0 +1,276 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#include "trace.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+	struct TSpan_Record {
+		const char* name;
+		uint64_t segment;
+		double device_time;
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	/*Chunk of the per-thread buffer - filled only by the owning thread, then handed to the writer and recycled*/
+	struct TChunk {
+		static constexpr size_t capacity = 4096;
+		std::array<TSpan_Record, capacity> spans;
+		size_t count = 0;
+		uint32_t tid = 0;
+	};
+
+	struct TThread_Buffer {
+		uint32_t tid = 0;
+		std::unique_ptr<TChunk> chunk;
+	};
+
+	/*Chunks allocated at start, filled chunks waiting for the writer before the filling thread waits*/
+	constexpr size_t pool_chunks = 8;
+	constexpr size_t flush_chunks = 64;
+
+	//guards the thread buffers, the recycled and the filled chunks
+	std::mutex buffers_mutex;
+	std::condition_variable chunks_filled;
+	std::condition_variable chunks_written;
+	std::vector<std::unique_ptr<TThread_Buffer>> buffers;
+	std::vector<std::unique_ptr<TChunk>> free_chunks;
+	std::deque<std::unique_ptr<TChunk>> filled_chunks;
+	std::atomic<uint64_t> generation{ 0 };
+	bool stopping = false;
+
+	//file is open for the whole tracing, spans are written by the writer thread as the chunks fill
+	FILE* trace_file = nullptr;
+	bool first_span = true;
+	bool write_failed = false;
+	std::thread writer;
+	std::chrono::steady_clock::time_point origin;
+
+	thread_local TThread_Buffer* local_buffer = nullptr;
+	thread_local uint64_t local_generation = 0;
+
+	uint64_t now() {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+	}
+
+	/*Recycled chunk of the given thread, a new one if the pool is empty. Caller holds buffers_mutex.*/
+	std::unique_ptr<TChunk> acquire_chunk(uint32_t tid) {
+		std::unique_ptr<TChunk> chunk;
+		if (free_chunks.empty()) {
+			chunk = std::make_unique<TChunk>();
+		}
+		else {
+			chunk = std::move(free_chunks.back());
+			free_chunks.pop_back();
+		}
+		chunk->count = 0;
+		chunk->tid = tid;
+		return chunk;
+	}
+
+	/*Buffer of the calling thread, registered on the first span of the thread*/
+	TThread_Buffer* thread_buffer() {
+		const uint64_t current = generation.load(std::memory_order_acquire);
+		if (local_buffer && local_generation == current) return local_buffer;
+
+		auto buffer = std::make_unique<TThread_Buffer>();
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+		buffer->tid = static_cast<uint32_t>(buffers.size() + 1);
+		buffer->chunk = acquire_chunk(buffer->tid);
+		local_buffer = buffer.get();
+		local_generation = current;
+		buffers.push_back(std::move(buffer));
+		return local_buffer;
+	}
+
+	void write_chunk(const TChunk& chunk) {
+		for (size_t i = 0; i < chunk.count; ++i) {
+			const auto& s = chunk.spans[i];
+			if (std::fprintf(trace_file, "%s{\"name\":\"%s\",\"cat\":\"detection\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"segment\":%llu,\"device_time\":%.8f}}",
+				first_span ? "" : ",\n", s.name, s.begin / 1000.0, (s.end - s.begin) / 1000.0, chunk.tid, static_cast<unsigned long long>(s.segment), s.device_time) < 0) {
+				write_failed = true;
+			}
+			first_span = false;
+		}
+	}
+
+	/*Writer thread - writes the filled chunks without holding the lock and returns them to the pool, until stopped and drained*/
+	void write_filled() {
+		std::unique_lock<std::mutex> lock(buffers_mutex);
+		while (true) {
+			chunks_filled.wait(lock, []() { return stopping || !filled_chunks.empty(); });
+			while (!filled_chunks.empty()) {
+				auto chunk = std::move(filled_chunks.front());
+				filled_chunks.pop_front();
+
+				lock.unlock();
+				write_chunk(*chunk);
+				lock.lock();
+
+				free_chunks.push_back(std::move(chunk));
+				chunks_written.notify_all();
+			}
+			if (stopping) return;
+		}
+	}
+
+	void push(const TSpan_Record& span) {
+		TThread_Buffer* buffer = thread_buffer();
+		if (buffer->chunk->count == TChunk::capacity) {
+			//bounded memory - the thread waits only if the writer is flush_chunks behind
+			std::unique_lock<std::mutex> lock(buffers_mutex);
+			chunks_written.wait(lock, []() { return filled_chunks.size() < flush_chunks; });
+			filled_chunks.push_back(std::move(buffer->chunk));
+			buffer->chunk = acquire_chunk(buffer->tid);
+			lock.unlock();
+			chunks_filled.notify_one();
+		}
+		buffer->chunk->spans[buffer->chunk->count++] = span;
+	}
+
+	/*Tracing driven by the environment variable*/
+	struct TEnvironment_Trace {
+		TEnvironment_Trace() {
+			if (const char* path = std::getenv("DETECTION_TRACE")) {
+				if (*path) detection::trace::start(path);
+			}
+		}
+		~TEnvironment_Trace() {
+			detection::trace::stop();
+		}
+	} environment_trace;
+}
+
+namespace detection {
+	namespace trace {
+
+		std::atomic<bool> active{ false };
+
+		void start(const std::filesystem::path& path) {
+			//the previous tracing is finished first, the writer thread is not shared
+			stop();
+
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			buffers.clear();
+			free_chunks.clear();
+			for (size_t i = 0; i < pool_chunks; ++i) free_chunks.push_back(std::make_unique<TChunk>());
+			origin = std::chrono::steady_clock::now();
+			generation.fetch_add(1, std::memory_order_release);
+
+			//the failure is reported by stop()
+			trace_file = std::fopen(path.string().c_str(), "w");
+			write_failed = !trace_file || std::fputs("{\"traceEvents\":[\n", trace_file) < 0;
+			first_span = true;
+			stopping = false;
+			if (trace_file) writer = std::thread(write_filled);
+			active.store(trace_file != nullptr, std::memory_order_release);
+		}
+
+		bool stop() {
+			active.store(false, std::memory_order_release);
+			if (writer.joinable()) {
+				{
+					std::lock_guard<std::mutex> lock(buffers_mutex);
+					stopping = true;
+				}
+				chunks_filled.notify_one();
+				writer.join();
+			}
+
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			if (!trace_file) {
+				const bool written = !write_failed;
+				write_failed = false;
+				return written;
+			}
+
+			//chunks being filled, no thread may be tracing
+			for (const auto& buffer : buffers) {
+				write_chunk(*buffer->chunk);
+			}
+			if (std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", trace_file) < 0) write_failed = true;
+			if (std::fclose(trace_file) != 0) write_failed = true;
+			trace_file = nullptr;
+
+			buffers.clear();
+			free_chunks.clear();
+			generation.fetch_add(1, std::memory_order_release);
+			const bool written = !write_failed;
+			write_failed = false;
+			return written;
+		}
+
+		void CSpan::begin(const char* name, uint64_t segment, double device_time) {
+			mName = name;
+			mSegment = segment;
+			mDevice_Time = device_time;
+			mBegin = now();
+		}
+
+		void CSpan::end() {
+			const uint64_t end = now();
+			//span started before stop() is dropped
+			if (enabled()) push({ mName, mSegment, mDevice_Time, mBegin, end });
+		}
+	}
+}
@@ -0,0 +1,100 @@
+/* Examples and Documentation for
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ *
+ *
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+ /*
+  * @author = Bc. David Pivovar
+  */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+namespace detection {
+	namespace trace {
+
+		/*Starts recording of the spans to the Chrome trace JSON file. Spans are buffered per thread, filled buffers
+		 * of 4096 spans are written by a writer thread and recycled (a traced thread waits only when 64 filled
+		 * buffers are not written yet), the rest is written by stop().
+		 * Tracing is also started when the library is loaded with the DETECTION_TRACE environment
+		 * variable set to the file path and stopped when it is unloaded.
+		 */
+		void start(const std::filesystem::path& path);
+		/*Stops recording and finishes the file, must not run concurrently with the traced code, false if the file was not written*/
+		bool stop();
+
+		extern std::atomic<bool> active;
+
+		inline bool enabled() {
+			return active.load(std::memory_order_relaxed);
+		}
+
+		/*Span of the traced function tagged with segment and device time, name must be a string literal*/
+		class CSpan {
+		public:
+			CSpan(const char* name, uint64_t segment, double device_time) {
+				if (enabled()) begin(name, segment, device_time);
+			}
+			~CSpan() {
+				if (mName) end();
+			}
+			CSpan(const CSpan&) = delete;
+			CSpan& operator=(const CSpan&) = delete;
+
+		private:
+			const char* mName = nullptr;
+			uint64_t mSegment = 0;
+			double mDevice_Time = 0;
+			uint64_t mBegin = 0;
+
+			void begin(const char* name, uint64_t segment, double device_time);
+			void end();
+		};
+	}
+}
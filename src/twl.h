@@ -0,0 +1,107 @@
+/*
+ * @author = Bc. David Pivovar
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+/*Sliding window bounded by device time (and optionally by count) with (time, value) pairs in a contiguous ring
+ * Samples older than horizon before the newest sample are evicted, so the window covers the same duration
+ * regardless of the sampling rate and gaps. Insertion and eviction are O(1) amortised (the ring doubles when full),
+ * sum and sum of squares of the values are kept incrementally. Zero horizon or max_count disables the bound.
+ */
+template <class T>
+class twl
+{
+public:
+	explicit twl(double horizon = 0, size_t max_count = 0) : _horizon(horizon), _max_count(max_count) {};
+
+	void push_back(double time, T value) {
+		if (_count == _items.size()) grow();
+
+		_items[(_head + _count) % _items.size()] = { time, value };
+		_count++;
+		_sum += static_cast<double>(value);
+		_sum_sq += static_cast<double>(value) * static_cast<double>(value);
+
+		evict(time);
+	}
+
+	/*Evicts samples older than horizon before the given time and samples over max_count*/
+	void evict(double time) {
+		while (_count > 0 && ((_max_count > 0 && _count > _max_count) || (_horizon > 0 && _items[_head].first <= time - _horizon))) {
+			pop_front();
+		}
+	}
+
+	void clear() {
+		_head = 0;
+		_count = 0;
+		_sum = 0;
+		_sum_sq = 0;
+	}
+
+	size_t size() const { return _count; }
+	bool empty() const { return _count == 0; }
+
+	/*i-th sample from the oldest one*/
+	double time(size_t i) const { return _items[(_head + i) % _items.size()].first; }
+	const T& value(size_t i) const { return _items[(_head + i) % _items.size()].second; }
+	const T& back() const { return value(_count - 1); }
+
+	double sum() const { return _sum; }
+	double mean() const { return _count > 0 ? _sum / _count : 0; }
+	/*Population standard deviation*/
+	double std() const {
+		if (_count == 0) return 0;
+		const double m = mean();
+		const double variance = _sum_sq / _count - m * m;
+		return variance > 0 ? std::sqrt(variance) : 0;
+	}
+
+	std::vector<T> to_vector() const {
+		std::vector<T> result;
+		result.reserve(_count);
+		for (size_t i = 0; i < _count; ++i) result.push_back(value(i));
+		return result;
+	}
+
+	double horizon() const { return _horizon; }
+	size_t max_count() const { return _max_count; }
+
+private:
+	std::vector<std::pair<double, T>> _items;
+	size_t _head = 0;
+	size_t _count = 0;
+
+	double _horizon;
+	size_t _max_count;
+
+	double _sum = 0;
+	double _sum_sq = 0;
+
+	void pop_front() {
+		const double value = static_cast<double>(_items[_head].second);
+		_sum -= value;
+		_sum_sq -= value * value;
+		_head = (_head + 1) % _items.size();
+		_count--;
+
+		//restart the sums of an empty window, so the rounding errors do not accumulate
+		if (_count == 0) {
+			_sum = 0;
+			_sum_sq = 0;
+		}
+	}
+
+	void grow() {
+		std::vector<std::pair<double, T>> items(std::max<size_t>(_items.size() * 2, 8));
+		for (size_t i = 0; i < _count; ++i) items[i] = _items[(_head + i) % _items.size()];
+		_items = std::move(items);
+		_head = 0;
+	}
+};